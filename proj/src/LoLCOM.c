@@ -20,10 +20,14 @@
 #include "helper.h"
 #include "UART.h"
 #include "speaker.h"
+#include "input.h"
+#include "scheduler.h"
+#include "mem.h"
 
 static int proc_args(int argc, char **argv);
 static void print_usage(char **argv);
-int8_t lolcom_player1();
+static void lolcom_player1_exit();
+int8_t lolcom_player1(uint16_t mode);
 int8_t lolcom_player2();
 
 int main(int argc, char **argv) {
@@ -44,7 +48,7 @@ int main(int argc, char **argv) {
 static void print_usage(char **argv)
 {
 	printf("Usage:\n"
-			"       service run %s -args \"player1\"\n"
+			"       service run %s -args \"player1 [<VBE mode, hex>]\"\n"
 			"       service run %s -args \"player2\"\n"
 			"       service run %s -args \"speakerPWM <bitrate, filename>\"\n"
 			"       service run %s -args \"speaker1bit <filename>\"\n",
@@ -59,12 +63,23 @@ static int proc_args(int argc, char **argv)
 
 	//LoLCOM_player1()
 	if (strncmp(argv[1], "player1", strlen("player1")) == 0) {
-		if (argc != 2) {
+		if (argc != 2 && argc != 3) {
 			printf("LoLCOM: wrong number of arguments for LoLCOM_player1()\n");
 			return 1;
 		}
 
-		return lolcom_player1();
+		//Optional VBE mode, 8bpp modes (0x101, 0x105) use the indexed palette renderer
+		//16bpp RGB 5:6:5 modes (0x111, 0x114, 0x117) halve VRAM traffic compared to 0x112
+		unsigned long mode = VMODE;
+		if(argc == 3) {
+			mode = parse_ulong(argv[2], 16);
+			if (mode == ULONG_MAX || mode > 0xFFFF) {
+				printf("LoLCOM: invalid VBE mode\n");
+				return 1;
+			}
+		}
+
+		return lolcom_player1(mode);
 	}
 
 	//LoLCOM_player2()
@@ -107,9 +122,41 @@ static int proc_args(int argc, char **argv)
 }
 
 
-int8_t lolcom_player1() {
+//Gives every device back the way it was found, RTC interrupts stay enabled in the CMOS otherwise
+//Shared by the normal exit and every error path once interrupts are subscribed
+static void lolcom_player1_exit() {
+
+	sched_exit();
+	mouse_reset(ENABLED);
+	kbd_reset(ENABLED);
+	rtc_periodic_disable();
+	rtc_update_disable();
+	rtc_reset(TRUE);
+	rtc_unsubscribe();
+	timer_unsubscribe_int();
+	uart_reset(COM1_BASE);
+	uart_unsubscribe();
+}
+
+
+int8_t lolcom_player1(uint16_t mode) {
 
+	//Mode info is needed first, images are converted to the framebuffer format when loaded
+	if(vg_init_values(mode) == -1) {
+		printf("LoLCOM: couldn't get info for VBE mode 0x%X\n", mode);
+		return -1;
+	}
+
+	//Images decoded by each game state live in its arena
+	if(logic_arena_init() != 0) {
+		vg_free();
+		return -1;
+	}
+
+	//Menu surfaces converted before a failure are freed with the arenas
 	if(logic_menu_init() != 0) {
+		logic_resident_free();
+		vg_free();
 		return -1;
 	}
 
@@ -117,8 +164,18 @@ int8_t lolcom_player1() {
 
 	uart_set_conf(COM1_BASE, receive8N1_9600);
 
-	vg_init_values(VMODE);
-	vg_init(VMODE);
+	if(vg_init(mode) == NULL) {
+		vg_exit();
+		logic_resident_free();
+		vg_free();
+		return -1;
+	}
+
+	//Higher resolution modes (e.g. 0x11A, 1280x1024) show the play area scaled instead of a small island
+	vg_play_scale(PLAY_W, PLAY_H, MAX_SCALE);
+
+	logic_timing_init();
+	logic_keybinds_init();
 
 	int32_t kbd_irq = kbd_subscribe_int();
 	int32_t timer_irq = timer_subscribe_int();
@@ -131,6 +188,16 @@ int8_t lolcom_player1() {
 		return -1;
 	}
 
+	//Timed events (spawns, waves) run on RTC periodic interrupts
+	if(rtc_periodic_enable(EVENT_RS) != 0) {
+		printf("LoLCOM: RTC: couldn't enable periodic interrupts, enemies won't spawn on their own\n");
+	}
+
+	//Wall-clock time is cached once per second so reading it doesn't touch the RTC, state changes are logged with it
+	if(rtc_update_enable() != 0) {
+		printf("LoLCOM: RTC: couldn't enable update interrupts, time is read from the RTC registers\n");
+	}
+
 	//Try to enable 4th mouse packet
 	uint8_t id = mouse_magic_sequence();
 
@@ -139,9 +206,24 @@ int8_t lolcom_player1() {
 		id = 0;
 	}
 
+	//Raise sample rate above the 100 samples/s default
+	mouse_config_t mouse_conf = {MOUSE_RATE, MOUSE_RES, MOUSE_SCALE};
+
+	if(mouse_configure(mouse_conf) != 0) {
+		printf("LoLCOM: mouse: couldn't configure mouse, using defaults\n");
+	}
+
+	if(mouse_get_config(&mouse_conf) == 0) {
+		printf("LoLCOM: mouse: %d samples/s, resolution %d, scaling %s\n", mouse_conf.sample_rate,
+				mouse_conf.resolution, mouse_conf.scaling == SCALING_2_1 ? "2:1" : "1:1");
+	}
+
 	//Enable data reporting for mouse
 	if(mouse_command(ENABLE_DATA) != 0) {
-		mouse_reset(DISABLED);
+		lolcom_player1_exit();
+		vg_exit();
+		logic_resident_free();
+		vg_free();
 		return -1;
 	}
 
@@ -152,12 +234,21 @@ int8_t lolcom_player1() {
 	mouse_irq = BIT(mouse_irq);
 	com1_irq = BIT(com1_irq);
 
+	//Timer 0 runs at SCHED_HZ, each part of the game is called at its own rate
+	//Simulation is registered before rendering so a frame always shows the latest step
+	if(sched_init() != 0 || sched_register(logic_input_task, INPUT_HZ, 0) < 0 ||
+			sched_register(logic_sim_task, SIM_HZ, id) < 0 || sched_register(logic_render_task, RENDER_HZ, 0) < 0) {
+		lolcom_player1_exit();
+		vg_exit();
+		logic_resident_free();
+		vg_free();
+		return -1;
+	}
+
 	int ipc_status, dstatus;
 	message msg;
 
 	uint32_t kbd_code = 0;
-	uint8_t pnumber = 0;
-	uint8_t sync = 0;
 	uint32_t mouse_data;
 	uint32_t serial_rcv = 0;
 	uint8_t end = FALSE;
@@ -177,37 +268,38 @@ int8_t lolcom_player1() {
 				//Timer interrupt
 				if(msg.NOTIFY_ARG & timer_irq) {
 
-					//Game loop
-					logic_handler(0, NULL, NULL, 0, TIMER_INT);
+					//Calls input handling, simulation and rendering when they're due
+					sched_tick();
 					end = logic_check_end();
 				}
 
 				//Keyboard interrupts
 				if(msg.NOTIFY_ARG & kbd_irq) {
 
-					//Read output port for scancode
-					kbd_code = kbd_read();
+					//Read output port for scancode, without sleeping in the event loop
+					kbd_code = kbd_read_int();
 
 					//Check scancode read success
 					if (kbd_code == KBD_ERROR) {
-						mouse_reset(ENABLED);
-						kbd_reset(ENABLED);
-						rtc_reset(TRUE);
-						rtc_unsubscribe();
-						timer_unsubscribe_int();
-						uart_reset(COM1_BASE);
-						uart_unsubscribe();
+						lolcom_player1_exit();
 						vg_exit();
+						logic_resident_free();
 						vg_free();
 						printf("LoLCOM: keyboard: error reading from output buffer\n");
 						return -1;
 					}
-					logic_handler(kbd_code, NULL, NULL, GAME, KBD_INT);
+
+					if(kbd_code != KBD_NONE) {
+						input_push(KBD_INT, kbd_code);
+					}
 				}
 
-				//RTC Alarm interrupts
+				//RTC periodic and update ended interrupts, register C is read right away so the next one isn't held back
 				if(msg.NOTIFY_ARG & rtc_irq) {
-					logic_handler(0, NULL, NULL, 0, RTC_INT);
+					uint32_t regC = rtc_read_register(RTC_STATUS_C);
+
+					rtc_update_cache(regC);
+					input_push(RTC_INT, regC);
 				}
 
 				//Mouse interrupt
@@ -215,19 +307,14 @@ int8_t lolcom_player1() {
 
 					//Read output port for scancode
 					if(sys_inb(KBD_OUT_BUF, &mouse_data) != OK) {
-						mouse_reset(ENABLED);
-						kbd_reset(ENABLED);
-						rtc_reset(TRUE);
-						rtc_unsubscribe();
-						timer_unsubscribe_int();
-						uart_reset(COM1_BASE);
-						uart_unsubscribe();
+						lolcom_player1_exit();
 						vg_exit();
+						logic_resident_free();
 						vg_free();
 						printf("LoLCOM: mouse: error reading from output buffer\n");
 						return -1;
 					}
-					logic_handler(mouse_data, &pnumber, &sync, id, MOUSE_INT);
+					input_push(MOUSE_INT, mouse_data);
 				}
 
 				//COM1 Interrupt
@@ -236,20 +323,15 @@ int8_t lolcom_player1() {
 					serial_rcv = uart_receive();
 
 					if(serial_rcv == UART_ERROR) {
-						mouse_reset(ENABLED);
-						kbd_reset(ENABLED);
-						rtc_reset(TRUE);
-						rtc_unsubscribe();
-						timer_unsubscribe_int();
-						uart_reset(COM1_BASE);
-						uart_unsubscribe();
+						lolcom_player1_exit();
 						vg_exit();
+						logic_resident_free();
 						vg_free();
 						return -1;
 					} else if(serial_rcv == RCV_ERROR) {
 						printf("COM1: error in transmission\n");
 					} else {
-						logic_handler(serial_rcv, NULL, NULL, 0, SERIAL_INT);
+						input_push(SERIAL_INT, serial_rcv);
 					}
 				}
 				break;
@@ -260,18 +342,21 @@ int8_t lolcom_player1() {
 		}
 	}
 
-	mouse_reset(ENABLED);
-	kbd_reset(ENABLED);
-	rtc_reset(TRUE);
-	rtc_unsubscribe();
-	timer_unsubscribe_int();
-	uart_reset(COM1_BASE);
-	uart_unsubscribe();
+	lolcom_player1_exit();
+
+	printf("LoLCOM: mouse: effective sample rate %d samples/s\n", mouse_measured_rate());
+	input_print_stats();
+	logic_timing_print();
+	logic_arena_print();
+	printf("LoLCOM: RTC: %d seconds of uptime\n", rtc_clock_seconds());
 
 	//Frees all allocated memory for the game data and also frees VRAM
 	vg_exit();
+	logic_resident_free();
 	vg_free();
 
+	mem_print();
+
 	return 0;
 }
 
@@ -282,11 +367,13 @@ int8_t lolcom_player2() {
 
 	uart_set_conf(COM1_BASE, transmit8N1_9600);
 
+	//Mode info is needed first, images are converted to the framebuffer format when loaded
+	vg_init_values(VMODE);
+
 	if(logic_serial_init() != 0) {
 		return -1;
 	}
 
-	vg_init_values(VMODE);
 	vg_init(VMODE);
 
 	int32_t timer_irq = timer_subscribe_int();
@@ -330,8 +417,8 @@ int8_t lolcom_player2() {
 					//Keyboard interrupt
 					if (msg.NOTIFY_ARG & kbd_irq) {
 
-						//Read output port for scancode
-						kbd_code = kbd_read();
+						//Read output port for scancode, without sleeping in the event loop
+						kbd_code = kbd_read_int();
 
 						//Check scancode read success
 						if (kbd_code == KBD_ERROR) {
@@ -343,7 +430,9 @@ int8_t lolcom_player2() {
 							return -1;
 						}
 
-						logic_kbd_input(kbd_code, PLAYER2);
+						if(kbd_code != KBD_NONE) {
+							logic_kbd_input(kbd_code, PLAYER2);
+						}
 					}
 					break;
 
@@ -359,5 +448,7 @@ int8_t lolcom_player2() {
 	vg_exit();
 	logic_serial_free();
 
+	mem_print();
+
 	return 0;
 }
@@ -24,6 +24,17 @@
 #define PLAYER2			1
 #define GAME			0
 
+//Constants for timing
+
+#define SIM_HZ				60		//Simulation steps per second, every *_FRAMES constant counts these
+#define SIM_MAX_STEPS		4		//Simulation steps run on a single tick while catching up
+#define SIM_MAX_BACKLOG		12		//Simulation steps of backlog kept, older time is dropped
+#define TSC_CALIBRATE_TICKS	15		//Clock ticks used to measure the TSC frequency
+#define INPUT_HZ			250		//Rate queued input events are handled at
+#define RENDER_HZ			60		//Rendered frames per second
+#define EVENT_RS			0x0A	//RTC periodic interrupt rate select driving timed events (64 Hz)
+#define EVENT_HZ			64		//Timed event ticks per second, must match EVENT_RS
+
 //Constants for menu
 
 #define MENU_FRAMES			15
@@ -35,7 +46,8 @@
 //Constants for Game Over state
 
 #define OVER_ANIM_FRAMES	8
-#define FADE_FRAMES			20
+#define FADE_STEPS			8		//Fade steps from the normal tileset to the darkest one
+#define FADE_FRAMES			10		//Simulation steps each fade step is shown
 
 //Constants for entities
 
@@ -44,14 +56,50 @@
 #define IFRAME_ROW			2
 #define KNOCK_FRAMES		15
 #define I_FRAMES			60
+#define FLASH_FRAMES		6		//Length of the damage flash, indexed modes only
 #define WALK_ANIM_FRAMES	15
 #define MAX_SPEED			4
 #define SPAWN_RTC			0
 #define SPAWN_SERIAL		1
-#define SPAWN_RATE			5
+#define SPAWN_RATE			5		//Seconds between timed spawns on the first wave
 #define SWORD_W				14
 #define SWORD_H				24
 #define SWORD_FRAMES		30
+#define SPRITE_CACHE_N		8		//Different sprite sheets kept compiled at the same time
+#define TILESET_CACHE_N		4		//Different tilesets kept decoded at the same time
+
+//Memory arena sizes, each fits the largest PNG decode of its state plus what the state keeps
+
+#define ARENA_N				3				//One arena per state: MENU, PLAYER1, GAMEOVER
+#define ARENA_MENU_SIZE		(5 << 19)		//RGBA menu frame: file, inflated data and the unfiltered image
+#define ARENA_PLAYER1_SIZE	(2 << 20)		//Tileset decode, sprite sheets and the glyph atlas decode
+#define ARENA_GAMEOVER_SIZE	(2 << 20)		//Game over screen decode
+
+//Constants for timed spawns and waves, in EVENT_HZ ticks
+
+#define SPAWN_TICKS			(SPAWN_RATE * EVENT_HZ)
+#define SPAWN_MIN_TICKS		(EVENT_HZ * 3 / 2)	//Fastest spawn interval later waves reach
+#define WAVE_TICKS			(30 * EVENT_HZ)		//Length of a wave
+#define WAVE_SPEEDUP		80					//Spawn interval of each wave, in percent of the previous one
+#define DESPAWN_TICKS		(45 * EVENT_HZ)		//Timed spawns still alive after this long are removed
+
+//Constants for enemy behavior, timers count simulation steps
+
+#define AI_STATES			4		//States a behavior can have
+#define AI_EDGES			2		//Transitions leaving a state
+#define AI_PERIOD			0xFFFF	//State timer taken from the entity's period
+#define AI_DEFAULT_PERIOD	120
+#define AI_WINDUP_FRAMES	20		//Charging enemies stand still facing Link before dashing
+#define AI_DASH_FRAMES		90		//Longest dash
+#define AI_AIM_FRAMES		20		//Ranged enemies stand still facing Link before shooting
+#define AI_FAR_MARGIN		2		//Tiles beyond sight before a chasing enemy gives up
+
+//Constants for projectiles
+
+#define ROCK_SPEED			4
+#define ROCK_FRAMES			120		//Steps a rock flies before it disappears
+#define BEAM_SPEED			6
+#define BEAM_FRAMES			90		//Steps a sword beam flies, fired while Link has full hitpoints
 
 //File paths for initialization functions
 
@@ -60,8 +108,9 @@
 #define ENTITY_PATH		((const unsigned char*)"/tmp/resources/entity_data/")
 #define FONT_PATH		((const unsigned char*)"/tmp/resources/tilesets/Font18x14.png")
 #define IMG_PATH		((const unsigned char*)"/tmp/resources/images/")
-#define OVER_PATH		((const unsigned char*)"/tmp/resources/tilesets/Overworld32d")
 #define MUSIC_PATH		((const unsigned char*)"/tmp/resources/music/")
+#define ROCK_SPRITE		"/tmp/resources/sprite_sheets/Rock32.png"
+#define BEAM_SPRITE		"/tmp/resources/sprite_sheets/Sword32.png"
 
 //Flags for loading map files
 
@@ -73,12 +122,19 @@
 #define SPRITESHEET		BIT(5)
 #define	HITPOINTS		BIT(6)
 #define SPEED			BIT(7)
+#define BEHAVIOR		BIT(8)	//Behavior name, see ai_compile()
+#define SIGHT			BIT(9)
+#define PERIOD			BIT(10)
+#define DASH_SPEED		BIT(11)
 
 #define SCROLL_FRAMES	6
 
 //Constants for graphics
 
-#define VMODE			0x112			//Video mode used by the game
+#define VMODE			0x112			//Video mode used by the game unless another one is passed to player1
+#define PLAY_W			(16 * TILESIZE)	//Play area, status bar included, scaled as a whole on larger modes
+#define PLAY_H			(15 * TILESIZE)
+#define MAX_SCALE		3
 #define DOUBLEBUFFER	0
 #define PAGEFLIP		1
 
@@ -93,20 +149,27 @@
 #define FONT_START		48
 #define FONT_Y_ADJUST	16
 #define FONT_X_ADJUST	72
+#define FONT_RUN_MAX	16			//Characters a cached text run holds
 
 //Constants for mouse
 
 #define MOUSE_TOL		3
 #define MOUSE_SCROLL	3			//Mouse id returned when 4th packet with scroll wheel only is activated
 #define MOUSE_SCROLL_EX	4			//Mouse id returned when 4th packet with extra buttons is activated
+#define MOUSE_RATE		MOUSE_SAMPLE200	//Sample rate used in game (200 samples/s), lowers input latency
+#define MOUSE_RES		MOUSE_RES_4		//Resolution used in game (4 count/mm)
+#define MOUSE_SCALE		SCALING_1_1		//Scaling used in game (1:1)
 
 //Legend of LCOM event types
 
-typedef enum {KBD_INT, MOUSE_INT, SERIAL_INT, RTC_INT, TIMER_INT} origin_t;
+typedef enum {KBD_INT, MOUSE_INT, SERIAL_INT, RTC_INT} origin_t;
 typedef enum {MOVE_DOWN, MOVE_LEFT, MOVE_UP, MOVE_RIGHT, MOVE_NONE} event_t;
 typedef enum {NORMAL, ATTACKING, KNOCKBACK_DMG, IFRAMES} entity_state_t;
 typedef enum {MENU, PLAYER1, GAMEOVER, END} state_t;
 typedef enum {NA, MENUOPTION, PLAYER1_QUIT, EXITING, DIED} game_event_t;
+typedef enum {MOTION_WANDER, MOTION_CHASE, MOTION_DASH, MOTION_AIM, MOTION_STAND, MOTION_SHOOT} motion_t;
+typedef enum {COND_NONE, COND_TIMER, COND_NEAR, COND_FAR, COND_ALIGNED, COND_BLOCKED} ai_cond_t;
+typedef enum {ACTION_NONE, ACTION_UP, ACTION_DOWN, ACTION_LEFT, ACTION_RIGHT, ACTION_ATTACK, ACTION_CONFIRM, ACTION_BACK} action_t;
 
 //Legend of LCOM data structs
 
@@ -120,6 +183,11 @@ typedef struct {
 	int16_t y;
 } vector_t;
 
+typedef struct {
+	uint8_t key;				//Key index as returned by kbd_decode()
+	action_t action;
+} keybind_t;
+
 typedef struct {
 	uint16_t knockback;
 	uint16_t attack;
@@ -128,6 +196,28 @@ typedef struct {
 	uint16_t move;
 } cooldown_t;
 
+typedef struct {
+	uint8_t cond;				//ai_cond_t, COND_NONE ends the state's transitions
+	uint8_t next;				//State entered when cond holds
+} ai_edge_t;
+
+typedef struct {
+	uint8_t motion;				//motion_t, how the entity moves while in this state
+	uint16_t timer;				//Steps set when the state is entered, AI_PERIOD uses the entity's period
+	ai_edge_t edges[AI_EDGES];	//Checked in order every step, the first that holds is taken
+} ai_node_t;
+
+typedef struct {
+	const ai_node_t* nodes;		//Compiled behavior, AI_STATES states
+	uint8_t state;
+	uint16_t timer;
+	uint8_t sight;				//Tiles Link is noticed from, 0 sees the whole screen
+	uint16_t period;			//Steps between dashes or shots
+	uint8_t dash_speed;
+	uint8_t facing;				//event_t, set when a MOTION_AIM state is entered
+	uint8_t blocked;			//A map collision stopped the entity on the last step
+} ai_t;
+
 typedef struct {
 	point_t currmap;
 	uint8_t menu_frame;
@@ -142,8 +232,24 @@ typedef struct {
 } game_state_t;
 
 typedef struct {
-	unsigned char* tileset;
-	uint16_t tileset_width;
+	unsigned char* image;
+	uint16_t image_width;
+	uint16_t image_height;
+} png_t;
+
+typedef struct {
+	unsigned char* pixels;		//Pixels already in framebuffer format
+	uint16_t width;
+	uint16_t height;
+} surface_t;
+
+typedef struct {
+	png_t source;				//RGB image, kept so the game over fade can convert it again
+	surface_t tiles;			//Converted to the framebuffer format when loaded, the map is drawn from it
+} tileset_t;
+
+typedef struct {
+	tileset_t* tileset;			//Shared by every map using the same tileset, see logic_ltileset()
 	uint8_t tilesperline;
 	uint8_t ntiles;
 	uint8_t map[MAPSIZE];
@@ -151,8 +257,13 @@ typedef struct {
 } map_t;
 
 typedef struct {
-	unsigned char* spritesheet;
-	uint16_t spritesheet_width;
+	unsigned char* data;		//Span lists of every tile, see vg_sprite_compile()
+	uint32_t* tile_offset;		//Offset in data where each tile starts
+	uint8_t ntiles;
+} sprite_t;
+
+typedef struct {
+	sprite_t* sprite;			//Compiled sprite sheet, shared by every entity of the same type
 	uint8_t tilesperline;
 	uint8_t ntiles;
 	uint8_t currsprite;
@@ -165,22 +276,21 @@ typedef struct {
 	cooldown_t cooldown;
 	event_t movement;
 	entity_state_t state;
+	uint16_t spawn_id;			//Timed spawn that placed the entity, 0 if it wasn't one
+	ai_t ai;					//Enemy behavior, unused by Link and the sword
 } entity_t;
 
 typedef struct {
-	unsigned char* fontdata;
+	surface_t* glyphs;			//Glyph atlas in framebuffer format, shared by every font
 	unsigned char word[64];
 	uint8_t word_size;
 	uint16_t number;
-	uint16_t fontdata_width;
 	uint8_t tilesperline;
 	point_t coords;
+	surface_t run;				//Cached text run, word rendered in framebuffer format
+	uint16_t run_width;			//Width in pixels of the rendered word
+	uint16_t run_number;		//number the cached run was rendered with
+	uint8_t run_valid;			//FALSE forces the run to be rendered again
 } font_t;
 
-typedef struct {
-	unsigned char* image;
-	uint16_t image_width;
-	uint16_t image_height;
-} png_t;
-
 #endif //LOLCOM_H
@@ -6,6 +6,13 @@
 
 static int rtc_hook = RTC_HOOK;
 
+//Time registers snapshot taken on every update ended interrupt, in the format the RTC uses
+static rtc_date_t cached_date;
+static uint32_t cached_weekday;
+static uint32_t cached_century;
+static uint8_t cache_valid = FALSE;		//TRUE once a snapshot was taken while update interrupts are enabled
+static uint32_t clock_seconds = 0;		//Update ended interrupts handled, one per second
+
 int8_t rtc_subscribe() {
 
 	rtc_hook = RTC_HOOK;
@@ -172,25 +179,6 @@ int8_t rtc_display_config() {
 
 int8_t rtc_display_date() {
 
-	uint32_t regA;
-
-	do {
-
-		asm_cli;
-
-		regA = rtc_read_register(RTC_STATUS_A);
-
-		if(regA == RTC_ERROR) {
-			asm_sti;
-			return -1;
-		}
-
-		if((regA & UIP) == UIP) {
-			asm_sti;
-		}
-
-	} while((regA & UIP) == UIP);
-
 	uint32_t century;
 	uint32_t year;
 	uint32_t month;
@@ -200,16 +188,46 @@ int8_t rtc_display_date() {
 	uint32_t minute;
 	uint32_t second;
 
-	second = rtc_read_register(RTC_SECOND);
-	minute = rtc_read_register(RTC_MINUTE);
-	hour = rtc_read_register(RTC_HOUR);
-	weekday = rtc_read_register(RTC_WEEKDAY);
-	dayOfMonth = rtc_read_register(RTC_DAYMONTH);
-	month = rtc_read_register(RTC_MONTH);
-	year = rtc_read_register(RTC_YEAR);
-	century = rtc_read_register(RTC_CENTURY);
+	if(cache_valid == TRUE) {
+		century = cached_century;
+		year = cached_date.year;
+		month = cached_date.month;
+		dayOfMonth = cached_date.dayOfMonth;
+		weekday = cached_weekday;
+		hour = cached_date.hour;
+		minute = cached_date.minute;
+		second = cached_date.second;
+	} else {
+		uint32_t regA;
 
-	asm_sti();
+		do {
+
+			asm_cli;
+
+			regA = rtc_read_register(RTC_STATUS_A);
+
+			if(regA == RTC_ERROR) {
+				asm_sti;
+				return -1;
+			}
+
+			if((regA & UIP) == UIP) {
+				asm_sti;
+			}
+
+		} while((regA & UIP) == UIP);
+
+		second = rtc_read_register(RTC_SECOND);
+		minute = rtc_read_register(RTC_MINUTE);
+		hour = rtc_read_register(RTC_HOUR);
+		weekday = rtc_read_register(RTC_WEEKDAY);
+		dayOfMonth = rtc_read_register(RTC_DAYMONTH);
+		month = rtc_read_register(RTC_MONTH);
+		year = rtc_read_register(RTC_YEAR);
+		century = rtc_read_register(RTC_CENTURY);
+
+		asm_sti();
+	}
 
 	if(century == RTC_ERROR || year == RTC_ERROR || month == RTC_ERROR || dayOfMonth == RTC_ERROR ||
 			weekday == RTC_ERROR || hour == RTC_ERROR || minute == RTC_ERROR || second == RTC_ERROR) {
@@ -349,6 +367,11 @@ int8_t rtc_set_date(rtc_date_t date) {
 
 int8_t rtc_get_date(rtc_date_t* date) {
 
+	if(cache_valid == TRUE) {
+		*date = cached_date;
+		return 0;
+	}
+
 	uint32_t regA;
 
 	do {
@@ -482,3 +505,178 @@ int8_t rtc_setalarm_s(uint32_t seconds) {
 
 	return 0;
 }
+
+
+int8_t rtc_periodic_enable(uint8_t rs) {
+
+	if(rs < 3 || rs > RS_MASK) {
+		printf("RTC: periodic: invalid rate select\n");
+		return -1;
+	}
+
+	asm_cli();
+
+	uint32_t regA, regB;
+	regA = rtc_read_register(RTC_STATUS_A);
+	regB = rtc_read_register(RTC_STATUS_B);
+
+	if(regA == RTC_ERROR || regB == RTC_ERROR) {
+		asm_sti();
+		return -1;
+	}
+
+	if(rtc_write_register(RTC_STATUS_A, (regA & ~RS_MASK) | rs) != 0) {
+		rtc_reset(FALSE);
+		return -1;
+	}
+
+	if(rtc_write_register(RTC_STATUS_B, PIE | regB) != 0) {
+		rtc_reset(FALSE);
+		return -1;
+	}
+
+	//Clear any pending flag so the first periodic interrupt isn't held back
+	rtc_read_register(RTC_STATUS_C);
+
+	if(rtc_enableNMI() != 0) {
+		rtc_enableNMI();
+	}
+
+	asm_sti();
+
+	return 0;
+}
+
+
+int8_t rtc_periodic_disable() {
+
+	asm_cli();
+
+	uint32_t regA, regB;
+	regA = rtc_read_register(RTC_STATUS_A);
+	regB = rtc_read_register(RTC_STATUS_B);
+
+	if(regA == RTC_ERROR || regB == RTC_ERROR) {
+		asm_sti();
+		return -1;
+	}
+
+	if(rtc_write_register(RTC_STATUS_B, regB & ~PIE) != 0) {
+		rtc_reset(FALSE);
+		return -1;
+	}
+
+	if(rtc_write_register(RTC_STATUS_A, (regA & ~RS_MASK) | RS_DEFAULT) != 0) {
+		rtc_reset(FALSE);
+		return -1;
+	}
+
+	rtc_read_register(RTC_STATUS_C);
+
+	if(rtc_enableNMI() != 0) {
+		rtc_enableNMI();
+	}
+
+	asm_sti();
+
+	return 0;
+}
+
+
+int8_t rtc_update_enable() {
+
+	asm_cli();
+
+	uint32_t regB;
+	regB = rtc_read_register(RTC_STATUS_B);
+
+	if(regB == RTC_ERROR) {
+		asm_sti();
+		return -1;
+	}
+
+	if(rtc_write_register(RTC_STATUS_B, UIE | regB) != 0) {
+		rtc_reset(FALSE);
+		return -1;
+	}
+
+	rtc_read_register(RTC_STATUS_C);
+
+	if(rtc_enableNMI() != 0) {
+		rtc_enableNMI();
+	}
+
+	asm_sti();
+
+	return 0;
+}
+
+
+int8_t rtc_update_disable() {
+
+	cache_valid = FALSE;
+
+	asm_cli();
+
+	uint32_t regB;
+	regB = rtc_read_register(RTC_STATUS_B);
+
+	if(regB == RTC_ERROR) {
+		asm_sti();
+		return -1;
+	}
+
+	if(rtc_write_register(RTC_STATUS_B, regB & ~UIE) != 0) {
+		rtc_reset(FALSE);
+		return -1;
+	}
+
+	rtc_read_register(RTC_STATUS_C);
+
+	if(rtc_enableNMI() != 0) {
+		rtc_enableNMI();
+	}
+
+	asm_sti();
+
+	return 0;
+}
+
+
+void rtc_update_cache(uint32_t regC) {
+
+	if(regC == RTC_ERROR || (regC & UIF) == 0) {
+		return;
+	}
+
+	//The update just ended, registers stay stable for almost a second so UIP doesn't need checking
+	rtc_date_t date;
+	uint32_t weekday, century;
+
+	date.second = rtc_read_register(RTC_SECOND);
+	date.minute = rtc_read_register(RTC_MINUTE);
+	date.hour = rtc_read_register(RTC_HOUR);
+	weekday = rtc_read_register(RTC_WEEKDAY);
+	date.dayOfMonth = rtc_read_register(RTC_DAYMONTH);
+	date.month = rtc_read_register(RTC_MONTH);
+	date.year = rtc_read_register(RTC_YEAR);
+	century = rtc_read_register(RTC_CENTURY);
+
+	clock_seconds++;
+
+	//Keep the previous snapshot if any read failed
+	if(date.year == RTC_ERROR || date.month == RTC_ERROR || date.dayOfMonth == RTC_ERROR || weekday == RTC_ERROR ||
+			date.hour == RTC_ERROR || date.minute == RTC_ERROR || date.second == RTC_ERROR || century == RTC_ERROR) {
+		return;
+	}
+
+	cached_date = date;
+	cached_weekday = weekday;
+	cached_century = century;
+	cache_valid = TRUE;
+}
+
+
+uint32_t rtc_clock_seconds() {
+	return clock_seconds;
+}
@@ -58,6 +58,9 @@ typedef struct {
 #define RS1					BIT(1)	//Square wave / Periodic interrupts frequency
 #define RS2					BIT(2)	//Square wave / Periodic interrupts frequency
 #define RS3					BIT(3)	//Square wave / Periodic interrupts frequency
+#define RS_MASK				(RS0 | RS1 | RS2 | RS3)
+#define RS_DEFAULT			0x06	//Rate select left by the BIOS (1024 Hz)
+#define RS_HZ(rs)			(32768 >> ((rs) - 1))	//Periodic interrupt frequency of rate select rs (3 to 15)
 
 //RTC Status Register B
 
@@ -145,7 +148,7 @@ uint32_t rtc_enableNMI();
 //@return 0 upon success, -1 otherwise
 int8_t rtc_display_config();
 
-//Display RTC date and time
+//Display RTC date and time, from memory while update interrupts are enabled
 //@return 0 upon success, -1 otherwise
 int8_t rtc_display_date();
 
@@ -159,6 +162,7 @@ void rtc_reset(uint8_t isNMI_enabled);
 int8_t rtc_set_date(rtc_date_t date);
 
 //Fills rtc_date_t struct with current date
+//Served from memory while update interrupts are enabled, see rtc_update_enable()
 //@param date - struct to fill
 //@return 0 upon success, -1 otherwise
 int8_t rtc_get_date(rtc_date_t* date);
@@ -176,4 +180,28 @@ void rtc_DECtoBCD(rtc_date_t* date);
 //@return 0 upon success, -1 otherwise
 int8_t rtc_setalarm_s(uint32_t seconds);
 
+//Enables periodic interrupts at the rate given by a rate select value
+//@param rs - rate select written to register A, from 3 (8192 Hz) to 15 (2 Hz), see RS_HZ()
+//@return 0 upon success, -1 otherwise
+int8_t rtc_periodic_enable(uint8_t rs);
+
+//Disables periodic interrupts and restores the default rate select
+//@return 0 upon success, -1 otherwise
+int8_t rtc_periodic_disable();
+
+//Enables update ended interrupts, from then on rtc_update_cache() keeps a snapshot of the time
+//@return 0 upon success, -1 otherwise
+int8_t rtc_update_enable();
+
+//Disables update ended interrupts, dates are read from the RTC registers again
+//@return 0 upon success, -1 otherwise
+int8_t rtc_update_disable();
+
+//Takes a snapshot of the time registers if an update ended interrupt is flagged, called from the interrupt path
+//@param regC - register C read when the interrupt arrived
+void rtc_update_cache(uint32_t regC);
+
+//Returns the number of update ended interrupts handled, seconds elapsed since rtc_update_enable()
+uint32_t rtc_clock_seconds();
+
 #endif //RTC_H
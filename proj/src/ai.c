@@ -0,0 +1,156 @@
+#include <minix/syslib.h>
+#include <minix/drivers.h>
+#include <minix/types.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "LoLCOM.h"
+#include "ai.h"
+
+typedef struct {
+	const char* name;
+	ai_node_t nodes[AI_STATES];
+} ai_behavior_t;
+
+//State 0 is entered when the entity is loaded or hit, unused states are never reached
+static const ai_behavior_t behaviors[] = {
+	{"wander", {
+		{MOTION_WANDER, 0, {{COND_NONE, 0}}}
+	}},
+	{"chase", {
+		{MOTION_WANDER, 0, {{COND_NEAR, 1}}},					//0 - Link out of sight
+		{MOTION_CHASE, 0, {{COND_FAR, 0}}}						//1 - follow the flow field
+	}},
+	{"charge", {
+		{MOTION_WANDER, 0, {{COND_ALIGNED, 1}}},				//0 - wait for Link on the same row or column
+		{MOTION_AIM, AI_WINDUP_FRAMES, {{COND_TIMER, 2}}},		//1 - wind up facing Link
+		{MOTION_DASH, AI_DASH_FRAMES, {{COND_BLOCKED, 3}, {COND_TIMER, 3}}},	//2 - dash until a wall stops it
+		{MOTION_STAND, AI_PERIOD, {{COND_TIMER, 0}}}			//3 - rest before charging again
+	}},
+	{"ranged", {
+		{MOTION_WANDER, AI_PERIOD, {{COND_TIMER, 1}}},			//0 - reloading
+		{MOTION_WANDER, 0, {{COND_ALIGNED, 2}}},				//1 - wait for Link on the same row or column
+		{MOTION_AIM, AI_AIM_FRAMES, {{COND_TIMER, 3}}},			//2 - stand facing Link
+		{MOTION_SHOOT, 0, {{COND_TIMER, 0}}}					//3 - fire once, reload
+	}}
+};
+
+
+//Manhattan distance in tiles
+static uint16_t ai_distance(point_t tile, point_t target) {
+	return abs(target.x - tile.x) + abs(target.y - tile.y);
+}
+
+
+static uint8_t ai_in_sight(const ai_t* ai, point_t tile, point_t target) {
+	return ai->sight == 0 || ai_distance(tile, target) <= ai->sight;
+}
+
+
+static uint8_t ai_condition(const ai_t* ai, ai_cond_t cond, point_t tile, point_t target) {
+
+	switch(cond) {
+	case COND_TIMER:
+		return ai->timer == 0;
+	case COND_NEAR:
+		return ai_in_sight(ai, tile, target);
+	case COND_FAR:
+		return ai->sight != 0 && ai_distance(tile, target) > ai->sight + AI_FAR_MARGIN;
+	case COND_ALIGNED:
+		return (tile.x == target.x || tile.y == target.y) && ai_in_sight(ai, tile, target);
+	case COND_BLOCKED:
+		return ai->blocked;
+	default:
+		return FALSE;
+	}
+}
+
+
+//Direction from tile toward target along the axis furthest away
+static event_t ai_facing(point_t tile, point_t target) {
+
+	int16_t dx = target.x - tile.x;
+	int16_t dy = target.y - tile.y;
+
+	if(abs(dx) >= abs(dy)) {
+		return dx < 0 ? MOVE_LEFT : MOVE_RIGHT;
+	}
+
+	return dy < 0 ? MOVE_UP : MOVE_DOWN;
+}
+
+
+static void ai_enter(ai_t* ai, uint8_t state, point_t tile, point_t target) {
+
+	const ai_node_t* node = &ai->nodes[state];
+
+	ai->state = state;
+	ai->timer = node->timer == AI_PERIOD ? ai->period : node->timer;
+	ai->blocked = FALSE;
+
+	if(node->motion == MOTION_AIM) {
+		ai->facing = ai_facing(tile, target);
+	}
+}
+
+
+void ai_defaults(ai_t* ai) {
+	ai->nodes = behaviors[0].nodes;
+	ai->sight = 0;
+	ai->period = AI_DEFAULT_PERIOD;
+	ai->dash_speed = MAX_SPEED;
+	ai->facing = MOVE_DOWN;
+	ai_reset(ai);
+}
+
+
+int8_t ai_compile(ai_t* ai, const char* name) {
+
+	while(isspace((unsigned char) *name)) {
+		name++;
+	}
+
+	size_t i;
+	for(i = 0; i < sizeof(behaviors) / sizeof(behaviors[0]); i++) {
+		if(strncmp(name, behaviors[i].name, strlen(behaviors[i].name)) == 0) {
+			ai->nodes = behaviors[i].nodes;
+			ai_reset(ai);
+			return 0;
+		}
+	}
+
+	printf("ai: ai_compile: unknown behavior\n");
+	return -1;
+}
+
+
+void ai_reset(ai_t* ai) {
+
+	const ai_node_t* node = &ai->nodes[0];
+
+	ai->state = 0;
+	ai->timer = node->timer == AI_PERIOD ? ai->period : node->timer;
+	ai->blocked = FALSE;
+}
+
+
+motion_t ai_step(ai_t* ai, point_t tile, point_t target) {
+
+	if(ai->timer > 0) {
+		ai->timer--;
+	}
+
+	const ai_node_t* node = &ai->nodes[ai->state];
+
+	uint8_t e;
+	for(e = 0; e < AI_EDGES && node->edges[e].cond != COND_NONE; e++) {
+		if(ai_condition(ai, node->edges[e].cond, tile, target)) {
+			ai_enter(ai, node->edges[e].next, tile, target);
+			break;
+		}
+	}
+
+	return ai->nodes[ai->state].motion;
+}
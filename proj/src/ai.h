@@ -0,0 +1,27 @@
+#ifndef AI_H
+#define AI_H
+
+#include "LoLCOM.h"
+
+//-----------------------------------------------------
+//Enemy Behavior Function definitions
+//-----------------------------------------------------
+
+//Sets the default behavior (wander) and parameters, called before an entity file is read
+void ai_defaults(ai_t* ai);
+
+//Looks a behavior name up once, so stepping it never compares strings
+//@param name - behavior name read from the entity file: wander, chase, charge or ranged
+//@return 0 upon success, -1 if the name is unknown (the behavior doesn't change)
+int8_t ai_compile(ai_t* ai, const char* name);
+
+//Returns to the first state of the behavior, used when the entity is loaded or gets hit
+void ai_reset(ai_t* ai);
+
+//Runs one simulation step of the state machine: counts the state timer down and takes the first transition that holds
+//@param tile - tile the entity stands on
+//@param target - tile Link stands on
+//@return how the entity should move this step
+motion_t ai_step(ai_t* ai, point_t tile, point_t target);
+
+#endif //AI_H
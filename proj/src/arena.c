@@ -0,0 +1,275 @@
+#include <minix/syslib.h>
+#include <minix/drivers.h>
+#include <minix/types.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+static arena_t* registered[ARENA_MAX];	//Initialized arenas, searched by arena_current_free()
+static uint8_t nregistered = 0;
+static arena_t* current = NULL;
+
+
+static size_t arena_round(size_t size) {
+	return (size + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1);
+}
+
+
+//Moves the fill level up to "to", the new bytes are counted under the current tag
+static void arena_grow(arena_t* arena, size_t to) {
+
+	mem_tag_t tag = mem_current_tag();
+
+	if(arena->nruns == 0 || (arena->run_tag[arena->nruns - 1] != tag && arena->nruns < ARENA_RUNS)) {
+		arena->run_start[arena->nruns] = arena->used;
+		arena->run_tag[arena->nruns] = tag;
+		arena->nruns++;
+	}
+
+	mem_add(arena->run_tag[arena->nruns - 1], to - arena->used);
+
+	arena->used = to;
+
+	if(to > arena->high) {
+		arena->high = to;
+	}
+}
+
+
+//Moves the fill level down to "to", the bytes above it are given back under the tags they were counted with
+static void arena_drop(arena_t* arena, size_t to) {
+
+	size_t end = arena->used;
+
+	while(arena->nruns > 0 && end > to) {
+		uint8_t i = arena->nruns - 1;
+		size_t start = arena->run_start[i] > to ? arena->run_start[i] : to;
+
+		mem_sub(arena->run_tag[i], end - start);
+
+		if(arena->run_start[i] < to) {
+			break;
+		}
+
+		end = arena->run_start[i];
+		arena->nruns--;
+	}
+
+	arena->used = to;
+}
+
+
+int8_t arena_init(arena_t* arena, const char* name, size_t size) {
+
+	arena->base = (unsigned char*) malloc(size);
+	arena->size = size;
+	arena->used = 0;
+	arena->last = 0;
+	arena->high = 0;
+	arena->name = name;
+	arena->nruns = 0;
+
+	if(arena->base == NULL) {
+		printf("arena: arena_init: couldn't allocate %s arena\n", name);
+		arena->size = 0;
+		return -1;
+	}
+
+	if(nregistered < ARENA_MAX) {
+		registered[nregistered++] = arena;
+	}
+
+	return 0;
+}
+
+
+void arena_destroy(arena_t* arena) {
+
+	uint8_t i;
+	for(i = 0; i < nregistered; i++) {
+		if(registered[i] == arena) {
+			registered[i] = registered[--nregistered];
+			break;
+		}
+	}
+
+	if(current == arena) {
+		current = NULL;
+	}
+
+	arena_drop(arena, 0);
+
+	free(arena->base);
+	arena->base = NULL;
+	arena->size = 0;
+	arena->last = 0;
+}
+
+
+void* arena_alloc(arena_t* arena, size_t size) {
+
+	size_t start = arena->used;
+	size_t end = start + arena_round(size);
+
+	if(arena->base == NULL || end > arena->size || end < start) {
+		printf("arena: arena_alloc: %s arena is full\n", arena->name);
+		return NULL;
+	}
+
+	arena_grow(arena, end);
+	arena->last = start;
+
+	return arena->base + start;
+}
+
+
+void* arena_realloc(arena_t* arena, void* ptr, size_t old_size, size_t new_size) {
+
+	if(ptr == NULL) {
+		return arena_alloc(arena, new_size);
+	}
+
+	size_t offset = (unsigned char*) ptr - arena->base;
+
+	//Latest allocation, only the fill level changes
+	if(offset == arena->last) {
+		size_t end = offset + arena_round(new_size);
+
+		if(end > arena->size) {
+			printf("arena: arena_realloc: %s arena is full\n", arena->name);
+			return NULL;
+		}
+
+		if(end > arena->used) {
+			arena_grow(arena, end);
+		} else arena_drop(arena, end);
+
+		return ptr;
+	}
+
+	void* moved = arena_alloc(arena, new_size);
+
+	if(moved != NULL) {
+		memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+	}
+
+	return moved;
+}
+
+
+void arena_free(arena_t* arena, void* ptr) {
+
+	if(ptr == NULL || !arena_owns(arena, ptr)) {
+		return;
+	}
+
+	if((size_t) ((unsigned char*) ptr - arena->base) == arena->last) {
+		arena_drop(arena, arena->last);
+	}
+}
+
+
+uint8_t arena_owns(const arena_t* arena, const void* ptr) {
+	return arena->base != NULL && (const unsigned char*) ptr >= arena->base && (const unsigned char*) ptr < arena->base + arena->size;
+}
+
+
+size_t arena_mark(const arena_t* arena) {
+	return arena->used;
+}
+
+
+void arena_release(arena_t* arena, size_t mark) {
+
+	if(mark < arena->used) {
+		arena_drop(arena, mark);
+		arena->last = mark;
+	}
+}
+
+
+void* arena_settle(arena_t* arena, size_t mark, void* ptr, size_t size) {
+
+	unsigned char* dst = arena->base + mark;
+
+	memmove(dst, ptr, size);
+
+	arena_drop(arena, mark);
+	arena_grow(arena, mark + arena_round(size));
+	arena->last = mark;
+
+	return dst;
+}
+
+
+void arena_reset(arena_t* arena) {
+	arena_drop(arena, 0);
+	arena->last = 0;
+}
+
+
+void arena_report(const arena_t* arena) {
+	printf("LoLCOM: memory: %s arena used at most %d of %d KiB\n", arena->name, (arena->high + 1023) / 1024, arena->size / 1024);
+}
+
+
+void arena_use(arena_t* arena) {
+	current = arena;
+}
+
+
+arena_t* arena_current() {
+	return current;
+}
+
+
+//Arena holding ptr, NULL if it came from mem_alloc()
+static arena_t* arena_owner(const void* ptr) {
+
+	uint8_t i;
+	for(i = 0; i < nregistered; i++) {
+		if(arena_owns(registered[i], ptr)) {
+			return registered[i];
+		}
+	}
+
+	return NULL;
+}
+
+
+void* arena_current_alloc(size_t size) {
+
+	if(current == NULL) {
+		return mem_alloc(mem_current_tag(), size);
+	}
+
+	return arena_alloc(current, size);
+}
+
+
+void* arena_current_realloc(void* ptr, size_t old_size, size_t new_size) {
+
+	arena_t* owner = ptr == NULL ? current : arena_owner(ptr);
+
+	if(owner == NULL) {
+		return mem_realloc(mem_current_tag(), ptr, new_size);
+	}
+
+	return arena_realloc(owner, ptr, old_size, new_size);
+}
+
+
+void arena_current_free(void* ptr) {
+
+	if(ptr == NULL) {
+		return;
+	}
+
+	arena_t* owner = arena_owner(ptr);
+
+	if(owner == NULL) {
+		mem_free(ptr);
+	} else arena_free(owner, ptr);
+}
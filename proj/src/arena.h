@@ -0,0 +1,86 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "mem.h"
+
+//-----------------------------------------------------
+//Memory Arena Constants
+//-----------------------------------------------------
+
+#define ARENA_ALIGN			8		//Every allocation starts on a multiple of this
+#define ARENA_MAX			4		//Arenas arena_current_free() looks pointers up in
+#define ARENA_RUNS			16		//Tag changes tracked per arena, later ones are counted under the last tag
+
+//-----------------------------------------------------
+//Memory Arena Types
+//-----------------------------------------------------
+
+//One block carved in order, released all at once
+typedef struct {
+	unsigned char* base;
+	size_t size;
+	size_t used;		//Bytes carved so far
+	size_t last;		//Offset of the latest allocation, the only one that can grow in place or be given back
+	size_t high;		//Highest used since arena_init()
+	const char* name;	//Used in reports
+	size_t run_start[ARENA_RUNS];	//Offsets where the mem_tag_t of the allocations changes
+	uint8_t run_tag[ARENA_RUNS];
+	uint8_t nruns;
+} arena_t;
+
+//-----------------------------------------------------
+//Memory Arena Function definitions
+//-----------------------------------------------------
+
+//Allocates the arena's block, the only malloc an arena does
+//@return 0 upon success, -1 otherwise
+int8_t arena_init(arena_t* arena, const char* name, size_t size);
+
+//Frees the arena's block
+void arena_destroy(arena_t* arena);
+
+//Carves size bytes from the arena
+//@return pointer upon success, NULL if the arena is full
+void* arena_alloc(arena_t* arena, size_t size);
+
+//Grows or shrinks ptr, in place if it's the latest allocation, otherwise copies it to a new one
+//@param old_size - size ptr was allocated with
+//@return pointer upon success, NULL if the arena is full (ptr stays valid)
+void* arena_realloc(arena_t* arena, void* ptr, size_t old_size, size_t new_size);
+
+//Gives ptr back if it's the latest allocation, otherwise its space waits for arena_reset()
+void arena_free(arena_t* arena, void* ptr);
+
+//Returns TRUE if ptr points inside the arena's block
+uint8_t arena_owns(const arena_t* arena, const void* ptr);
+
+//Returns the current fill level, allocations made after it can be dropped with arena_release()
+size_t arena_mark(const arena_t* arena);
+
+//Drops every allocation made after mark
+void arena_release(arena_t* arena, size_t mark);
+
+//Keeps size bytes at ptr and drops everything else allocated after mark, ptr's data is moved down to mark
+//Used to keep a decoded image while giving back the decoder's scratch buffers
+//@return new address of the data
+void* arena_settle(arena_t* arena, size_t mark, void* ptr, size_t size);
+
+//Drops every allocation, the high water mark is kept
+void arena_reset(arena_t* arena);
+
+//Prints the arena's size and high water mark
+void arena_report(const arena_t* arena);
+
+//Selects the arena arena_current_*() allocate from, NULL uses mem_alloc()
+void arena_use(arena_t* arena);
+
+arena_t* arena_current();
+
+//Allocation functions working on the current arena, used by the PNG decoder
+//Bytes are counted under mem_current_tag(), without a current arena they come from mem_alloc()
+//arena_current_free() and arena_current_realloc() also accept pointers from other arenas or from mem_alloc()
+void* arena_current_alloc(size_t size);
+void* arena_current_realloc(void* ptr, size_t old_size, size_t new_size);
+void arena_current_free(void* ptr);
+
+#endif //ARENA_H
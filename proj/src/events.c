@@ -0,0 +1,143 @@
+#include <minix/syslib.h>
+#include <minix/drivers.h>
+#include <minix/types.h>
+
+#include "events.h"
+
+static tevent_t heap[EVENTS_MAX];	//Binary min-heap ordered by (due, seq)
+static uint8_t nevents = 0;
+static uint32_t current_tick = 0;
+static uint32_t next_seq = 0;
+
+
+//Returns TRUE if event a must fire before event b
+//Ticks are compared by difference so the order survives the counter wrapping
+static uint8_t events_before(const tevent_t* a, const tevent_t* b) {
+
+	int32_t diff = (int32_t) (a->due - b->due);
+
+	if(diff != 0) {
+		return diff < 0;
+	}
+
+	return (int32_t) (a->seq - b->seq) < 0;
+}
+
+
+static void events_sift_up(uint8_t i) {
+
+	tevent_t event = heap[i];
+
+	while(i > 0) {
+		uint8_t parent = (i - 1) / 2;
+
+		if(!events_before(&event, &heap[parent])) {
+			break;
+		}
+
+		heap[i] = heap[parent];
+		i = parent;
+	}
+
+	heap[i] = event;
+}
+
+
+static void events_sift_down(uint8_t i) {
+
+	tevent_t event = heap[i];
+
+	while(2 * i + 1 < nevents) {
+		uint8_t child = 2 * i + 1;
+
+		if(child + 1 < nevents && events_before(&heap[child + 1], &heap[child])) {
+			child++;
+		}
+
+		if(!events_before(&heap[child], &event)) {
+			break;
+		}
+
+		heap[i] = heap[child];
+		i = child;
+	}
+
+	heap[i] = event;
+}
+
+
+void events_clear() {
+	nevents = 0;
+	current_tick = 0;
+	next_seq = 0;
+}
+
+
+uint8_t events_free() {
+	return EVENTS_MAX - nevents;
+}
+
+
+int8_t events_push(uint32_t delay, tevent_type_t type, uint32_t arg) {
+
+	if(nevents >= EVENTS_MAX) {
+		printf("events: events_push: too many pending events\n");
+		return -1;
+	}
+
+	heap[nevents].due = current_tick + delay;
+	heap[nevents].seq = next_seq++;
+	heap[nevents].type = type;
+	heap[nevents].arg = arg;
+
+	nevents++;
+	events_sift_up(nevents - 1);
+
+	return 0;
+}
+
+
+void events_cancel(tevent_type_t type) {
+
+	uint8_t i, kept = 0;
+	for(i = 0; i < nevents; i++) {
+		if(heap[i].type != type) {
+			heap[kept++] = heap[i];
+		}
+	}
+
+	nevents = kept;
+
+	//Rebuild the heap bottom up, (due, seq) keeps the order of events pushed on the same tick
+	for(i = nevents / 2; i > 0; i--) {
+		events_sift_down(i - 1);
+	}
+}
+
+
+void events_tick() {
+	current_tick++;
+}
+
+
+int8_t events_pop_due(tevent_t* event) {
+
+	if(nevents == 0 || (int32_t) (heap[0].due - current_tick) > 0) {
+		return -1;
+	}
+
+	*event = heap[0];
+
+	nevents--;
+	if(nevents > 0) {
+		heap[0] = heap[nevents];
+		events_sift_down(0);
+	}
+
+	return 0;
+}
+
+
+uint32_t events_now() {
+	return current_tick;
+}
@@ -0,0 +1,59 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include "LoLCOM.h"
+
+//-----------------------------------------------------
+//Timed Events Types
+//-----------------------------------------------------
+
+typedef enum {TEVENT_SPAWN, TEVENT_DESPAWN, TEVENT_WAVE} tevent_type_t;
+
+typedef struct {
+	uint32_t due;			//Event tick the event fires on
+	uint32_t seq;			//Insertion order, events due on the same tick fire in the order they were pushed
+	tevent_type_t type;
+	uint32_t arg;			//Meaning depends on type
+} tevent_t;
+
+//-----------------------------------------------------
+//Timed Events Constants
+//-----------------------------------------------------
+
+#define EVENTS_RESERVED		2		//Slots only the spawn and wave events use, despawns leave them free
+#define EVENTS_MARGIN		8		//Slack for timing changes
+//Maximum number of pending events: at the fastest spawn rate a despawn is pushed every SPAWN_MIN_TICKS and lasts DESPAWN_TICKS
+#define EVENTS_MAX			(DESPAWN_TICKS / SPAWN_MIN_TICKS + EVENTS_RESERVED + EVENTS_MARGIN)
+
+//-----------------------------------------------------
+//Timed Events Function definitions
+//-----------------------------------------------------
+
+//Discards every pending event and restarts the event clock at tick 0
+void events_clear();
+
+//Schedules an event "delay" ticks after the current tick
+//@param delay - ticks until the event is due, 0 makes it due on the current tick
+//@param type - event type
+//@param arg - value returned with the event
+//@return 0 upon success, -1 if EVENTS_MAX events are already pending
+int8_t events_push(uint32_t delay, tevent_type_t type, uint32_t arg);
+
+//Discards every pending event of one type
+void events_cancel(tevent_type_t type);
+
+//Returns how many more events can be pushed
+uint8_t events_free();
+
+//Advances the event clock by one tick
+void events_tick();
+
+//Removes the earliest pending event if it's due
+//@param event - struct to fill with the event
+//@return 0 upon success, -1 if no event is due
+int8_t events_pop_due(tevent_t* event);
+
+//Returns the current event tick
+uint32_t events_now();
+
+#endif //EVENTS_H
@@ -0,0 +1,84 @@
+#include <minix/syslib.h>
+#include <minix/drivers.h>
+#include <minix/types.h>
+
+#include "LoLCOM.h"
+#include "flowfield.h"
+
+//Neighbour offsets and the direction a tile reached through them takes back toward the tile it came from
+static const int8_t neighbour_dx[4] = {0, 0, -1, 1};
+static const int8_t neighbour_dy[4] = {-1, 1, 0, 0};
+static const uint8_t neighbour_back[4] = {MOVE_DOWN, MOVE_UP, MOVE_RIGHT, MOVE_LEFT};
+
+
+void flow_invalidate(flowfield_t* field) {
+	field->valid = FALSE;
+}
+
+
+uint8_t flow_update(flowfield_t* field, const uint8_t* collision, point_t target) {
+
+	if(field->valid == TRUE && field->target.x == target.x && field->target.y == target.y) {
+		return FALSE;
+	}
+
+	size_t i;
+	for(i = 0; i < MAPSIZE; i++) {
+		field->dist[i] = FLOW_UNREACHED;
+		field->dir[i] = MOVE_NONE;
+	}
+
+	field->target = target;
+	field->valid = TRUE;
+
+	if(target.x < 0 || target.x >= MWIDTH || target.y < 0 || target.y >= MHEIGHT) {
+		return TRUE;
+	}
+
+	//Every tile enters the queue once, so MAPSIZE entries are enough
+	uint8_t queue[MAPSIZE];
+	uint8_t head = 0, tail = 0;
+
+	//The target is a seed even if it's half blocked, it's where Link stands
+	uint8_t start = target.x + target.y * MWIDTH;
+	field->dist[start] = 0;
+	queue[tail++] = start;
+
+	while(head < tail) {
+		uint8_t tile = queue[head++];
+		int16_t x = tile % MWIDTH;
+		int16_t y = tile / MWIDTH;
+
+		uint8_t n;
+		for(n = 0; n < 4; n++) {
+			int16_t nx = x + neighbour_dx[n];
+			int16_t ny = y + neighbour_dy[n];
+
+			if(nx < 0 || nx >= MWIDTH || ny < 0 || ny >= MHEIGHT) {
+				continue;
+			}
+
+			uint8_t next = nx + ny * MWIDTH;
+
+			if(field->dist[next] != FLOW_UNREACHED || collision[next] != FLOW_PASSABLE) {
+				continue;
+			}
+
+			field->dist[next] = field->dist[tile] + 1;
+			field->dir[next] = neighbour_back[n];
+			queue[tail++] = next;
+		}
+	}
+
+	return TRUE;
+}
+
+
+event_t flow_dir(const flowfield_t* field, point_t tile) {
+
+	if(field->valid == FALSE || tile.x < 0 || tile.x >= MWIDTH || tile.y < 0 || tile.y >= MHEIGHT) {
+		return MOVE_NONE;
+	}
+
+	return (event_t) field->dir[tile.x + tile.y * MWIDTH];
+}
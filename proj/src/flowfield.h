@@ -0,0 +1,40 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include "LoLCOM.h"
+
+//-----------------------------------------------------
+//Flow Field Types
+//-----------------------------------------------------
+
+//Shortest path directions from every tile of a map toward one target tile
+typedef struct {
+	uint8_t dist[MAPSIZE];		//Steps to the target tile, FLOW_UNREACHED if there's no path
+	uint8_t dir[MAPSIZE];		//event_t to follow from each tile, MOVE_NONE on the target or unreached tiles
+	point_t target;				//Tile the field leads to
+	uint8_t valid;				//FALSE forces the next flow_update() to rebuild the field
+} flowfield_t;
+
+//-----------------------------------------------------
+//Flow Field Constants
+//-----------------------------------------------------
+
+#define FLOW_UNREACHED		0xFF
+#define FLOW_PASSABLE		1		//Collision type enemies can walk through, half blocked tiles aren't used for paths
+
+//-----------------------------------------------------
+//Flow Field Function definitions
+//-----------------------------------------------------
+
+//Forces the field to be rebuilt on the next flow_update(), called when the map changes
+void flow_invalidate(flowfield_t* field);
+
+//Rebuilds the field with a breadth first search from target over the MWIDTH x MHEIGHT collision grid
+//Does nothing if the field is valid and already leads to target
+//@return TRUE if the field was rebuilt, FALSE otherwise
+uint8_t flow_update(flowfield_t* field, const uint8_t* collision, point_t target);
+
+//Returns the direction (MOVE_*) to take from tile toward the target, MOVE_NONE if there's none
+event_t flow_dir(const flowfield_t* field, point_t tile);
+
+#endif //FLOWFIELD_H
@@ -4,6 +4,9 @@
 #include <errno.h>
 #include <limits.h>
 
+#include "LoLCOM.h"
+#include "mem.h"
+
 #define SSIZE_MAX INT_MAX //MINIX defines ssize_t as typedef int ssize_t in types.h
 #define _GETDELIM_GROWBY 128    /* amount to grow line buffer by */
 #define _GETDELIM_MINLEN 4      /* minimum line buffer size */
@@ -26,7 +29,7 @@ ssize_t getdelim(char** lineptr, size_t* n, int delimiter, FILE* stream) {
 	/* resize (or allocate) the line buffer if necessary */
 	buf = *lineptr;
 	if (buf == NULL || *n < _GETDELIM_MINLEN) {
-		buf = realloc(*lineptr, _GETDELIM_GROWBY);
+		buf = mem_realloc(MEM_PARSING, *lineptr, _GETDELIM_GROWBY);
 		if (buf == NULL) {
 			/* ENOMEM */
 			return -1;
@@ -46,7 +49,7 @@ ssize_t getdelim(char** lineptr, size_t* n, int delimiter, FILE* stream) {
 		}
 		bytes++;
 		if (bytes >= *n - 1) {
-			buf = realloc(*lineptr, *n + _GETDELIM_GROWBY);
+			buf = mem_realloc(MEM_PARSING, *lineptr, *n + _GETDELIM_GROWBY);
 			if (buf == NULL) {
 				/* ENOMEM */
 				return -1;
@@ -111,3 +114,41 @@ int16_t clamp_int16(int16_t value, int16_t min, int16_t max) {
 	  const int16_t temp = value < min ? min : value;
 	  return temp > max ? max : temp;
 }
+
+
+uint64_t rdtsc() {
+	uint32_t low, high;
+	asm volatile("rdtsc" : "=a" (low), "=d" (high));
+	return ((uint64_t) high << 32) | low;
+}
+
+
+uint64_t tsc_calibrate() {
+
+	clock_t start, now;
+	uint32_t hz = sys_hz();
+
+	if(getuptime(&start) != OK) {
+		return 0;
+	}
+
+	//Align with the start of a clock tick
+	do {
+		if(getuptime(&now) != OK) {
+			return 0;
+		}
+	} while(now == start);
+
+	uint64_t tsc_start = rdtsc();
+	start = now;
+
+	do {
+		if(getuptime(&now) != OK) {
+			return 0;
+		}
+	} while(now - start < TSC_CALIBRATE_TICKS);
+
+	uint64_t tsc_end = rdtsc();
+
+	return (tsc_end - tsc_start) * hz / (now - start);
+}
@@ -1,10 +1,19 @@
 #ifndef HELPER_H
 #define HELPER_H
 
+//Reads stream up to delimiter into *lineptr, the line buffer comes from mem_realloc(), free it with mem_free()
 ssize_t getdelim(char** lineptr, size_t* n, int delimiter, FILE* stream);
 
 unsigned long parse_ulong(char* str, int base);
 
 int16_t clamp_int16(int16_t value, int16_t min, int16_t max);
 
+//Reads the processor's time stamp counter
+uint64_t rdtsc();
+
+//Measures TSC cycles per second against the system clock ticks
+//Busy waits for TSC_CALIBRATE_TICKS clock ticks, call before reprogramming Timer 0
+//Returns cycles per second, 0 upon failure
+uint64_t tsc_calibrate();
+
 #endif //HELPER_H
@@ -18,6 +18,7 @@
 #define TIMEOUT 			3 		//Number of times to retry a read/write operation
 #define MAX_UINT16 			0xFFFF 	//Maximum value of an unsigned 16bit integer
 #define KBD_ERROR 			0xFFFF 	//Error value that doesn't interfere with possible data values, response values or scancodes
+#define KBD_NONE			0xFFFE	//kbd_read_int() found no valid byte, nothing to handle
 #define ENABLED				0x01
 #define DISABLED			0x00
 #define TOLERANCE			2		//Tolerance for movement of the mouse in test_gesture
@@ -54,6 +55,9 @@
 #define SAMPLE_RATE			0xF3
 #define MOUSE_ID			0xF2
 #define MOUSE_DEFAULTS		0xF6
+#define SET_RESOLUTION		0xE8 //Followed by resolution byte
+#define SCALING_1_1			0xE6 //Set scaling 1:1
+#define SCALING_2_1			0xE7 //Set scaling 2:1
 
 //PS/2 Mouse Packets
 #define SYNC_BIT			BIT(3) //1st packet always has this bit set to 1, using it to sync
@@ -84,6 +88,15 @@
 #define MOUSE_SAMPLE200		0xC8
 #define MOUSE_SAMPLE100		0x64
 #define MOUSE_SAMPLE80		0x50
+#define MOUSE_SAMPLE60		0x3C
+#define MOUSE_SAMPLE40		0x28
+#define MOUSE_SAMPLE20		0x14
+#define MOUSE_SAMPLE10		0x0A
+
+#define MOUSE_RES_1			0x00 //1 count/mm
+#define MOUSE_RES_2			0x01 //2 count/mm
+#define MOUSE_RES_4			0x02 //4 count/mm (default)
+#define MOUSE_RES_8			0x03 //8 count/mm
 
 //PS/2 Device Responses
 #define KBD_ACK 			0xFA //Command acknowledged
@@ -109,5 +122,15 @@
 #define K_MAKE				0x25
 #define L_MAKE				0x26
 #define TWOB_CODE 			0xE0 //Prefix of 2 Byte scancodes
+#define PAUSE_CODE			0xE1 //Prefix of the Pause key sequence, 2 more bytes follow
+#define PAUSE_BYTES			2
+
+//Extended keys (sent after TWOB_CODE), KEY_EXT() gives their index in the key bitmap
+#define KEY_EXT(x)			(0x80 | (x))
+#define UP_MAKE				0x48
+#define DOWN_MAKE			0x50
+#define LEFT_MAKE			0x4B
+#define RIGHT_MAKE			0x4D
+#define KP_ENTER_MAKE		0x1C
 
 #endif //I8042_H
@@ -0,0 +1,80 @@
+#include <minix/syslib.h>
+#include <minix/drivers.h>
+#include <minix/types.h>
+
+#include "input.h"
+#include "helper.h"
+
+//Single-producer single-consumer ring, head is only written by input_push()
+//and tail only by input_pop() so neither side needs a lock
+static input_event_t queue[INPUT_QUEUE_SIZE];
+static volatile uint32_t queue_head = 0;
+static volatile uint32_t queue_tail = 0;
+
+static input_stats_t stats = {0, 0, 0, 0};
+
+//Stops the compiler from reordering the event write with the index update
+#define COMPILER_BARRIER()	asm volatile("" ::: "memory")
+
+int8_t input_push(origin_t origin, uint32_t data) {
+
+	uint32_t head = queue_head;
+
+	if(head - queue_tail >= INPUT_QUEUE_SIZE) {
+		stats.dropped++;
+		return -1;
+	}
+
+	input_event_t* event = &queue[head & (INPUT_QUEUE_SIZE - 1)];
+	event->tsc = rdtsc();
+	event->data = data;
+	event->origin = origin;
+
+	COMPILER_BARRIER();
+	queue_head = head + 1;
+
+	return 0;
+}
+
+
+int8_t input_pop(input_event_t* event) {
+
+	uint32_t tail = queue_tail;
+
+	if(tail == queue_head) {
+		return -1;
+	}
+
+	COMPILER_BARRIER();
+	*event = queue[tail & (INPUT_QUEUE_SIZE - 1)];
+	COMPILER_BARRIER();
+	queue_tail = tail + 1;
+
+	uint64_t latency = rdtsc() - event->tsc;
+
+	stats.events++;
+	stats.total_cycles += latency;
+	if(latency > stats.max_cycles) {
+		stats.max_cycles = latency;
+	}
+
+	return 0;
+}
+
+
+void input_flush() {
+	queue_tail = queue_head;
+}
+
+
+void input_print_stats() {
+
+	uint32_t average = 0;
+
+	if(stats.events != 0) {
+		average = stats.total_cycles / stats.events;
+	}
+
+	printf("LoLCOM: input: %d events, %d dropped, latency avg %u cycles, max %u cycles\n",
+			stats.events, stats.dropped, average, (uint32_t) stats.max_cycles);
+}
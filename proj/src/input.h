@@ -0,0 +1,51 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "LoLCOM.h"
+
+//-----------------------------------------------------
+//Input Queue Types
+//-----------------------------------------------------
+
+typedef struct {
+	uint64_t tsc;		//Time stamp counter value when the interrupt was handled
+	uint32_t data;		//Scancode, mouse byte or serial byte, depending on origin
+	origin_t origin;	//Device that generated the event
+} input_event_t;
+
+typedef struct {
+	uint32_t events;		//Events drained since the start
+	uint32_t dropped;		//Events lost because the queue was full
+	uint64_t total_cycles;	//Sum of queue latencies (push to drain) in TSC cycles
+	uint64_t max_cycles;	//Highest queue latency in TSC cycles
+} input_stats_t;
+
+//-----------------------------------------------------
+//Input Queue Constants
+//-----------------------------------------------------
+
+#define INPUT_QUEUE_SIZE	256		//Must be a power of 2
+
+//-----------------------------------------------------
+//Input Queue Function definitions
+//-----------------------------------------------------
+
+//Stores a timestamped event, called only from the interrupt path (single producer)
+//@param origin - device that generated the event
+//@param data - data read from the device
+//@return 0 upon success, -1 if the queue is full and the event was dropped
+int8_t input_push(origin_t origin, uint32_t data);
+
+//Removes the oldest event, called only from the game tick (single consumer)
+//Updates latency statistics using the time of the call
+//@param event - struct to fill with the event
+//@return 0 upon success, -1 if the queue is empty
+int8_t input_pop(input_event_t* event);
+
+//Discards every queued event, called on state changes
+void input_flush();
+
+//Prints event count, dropped events and average/max queue latency
+void input_print_stats();
+
+#endif //INPUT_H
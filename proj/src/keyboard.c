@@ -1,5 +1,6 @@
 #include <minix/syslib.h>
 #include <minix/drivers.h>
+#include <string.h>
 #include "i8042.h"
 #include "i8254.h"
 #include "timer.h"
@@ -8,6 +9,10 @@
 
 static int kbd_hook; //Keyboard hook id
 
+static uint32_t key_bitmap[256 / 32];	//Bit set for every key held down, see kbd_decode()
+static uint8_t key_prefix = 0;			//Extended prefix received, the next byte is an extended key
+static uint8_t key_skip = 0;			//Bytes of the Pause sequence still to ignore
+
 //Sleep 20ms*cycles for i8042 interfacing
 //Uses tickdelay from MINIX
 void delay(int cycles) {
@@ -150,6 +155,85 @@ int kbd_read() {
 }
 
 
+//Reads a scancode from the interrupt handler path, never sleeps
+//kbd_read() is kept for command responses, which may need a retry
+int kbd_read_int() {
+	unsigned long status, data;
+
+	if(sys_inb(STATUS_PORT, &status) != OK) {
+		printf("keyboard: kbd_read_int: failed to read PS/2 controller status byte\n");
+		return KBD_ERROR;
+	}
+
+	//The interrupt was raised for a byte that's already gone
+	if((status & OUT_BUF_STATUS) == 0) {
+		return KBD_NONE;
+	}
+
+	if(sys_inb(KBD_OUT_BUF, &data) != OK) {
+		printf("keyboard: kbd_read_int: failed to read kbd data\n");
+		return KBD_ERROR;
+	}
+
+	//A byte with a communication error is dropped, the next one is still valid
+	if(status & (PARITY_ERROR | TIME_OUT_ERROR)) {
+		return KBD_NONE;
+	}
+
+	return data;
+}
+
+
+//Decodes one scancode set 1 byte and updates the pressed key bitmap
+int16_t kbd_decode(uint8_t scancode, uint8_t* pressed) {
+
+	if(key_skip > 0) {
+		key_skip--;
+		return -1;
+	}
+
+	if(scancode == TWOB_CODE) {
+		key_prefix = TRUE;
+		return -1;
+	}
+
+	//Pause has no break code and doesn't fit the bitmap, its bytes are ignored
+	if(scancode == PAUSE_CODE) {
+		key_skip = PAUSE_BYTES;
+		return -1;
+	}
+
+	uint8_t key = scancode & ~BIT(7);
+
+	if(key_prefix == TRUE) {
+		key = KEY_EXT(key);
+		key_prefix = FALSE;
+	}
+
+	*pressed = (scancode & BIT(7)) ? FALSE : TRUE;
+
+	if(*pressed == TRUE) {
+		key_bitmap[key / 32] |= (1u << (key % 32));
+	} else {
+		key_bitmap[key / 32] &= ~(1u << (key % 32));
+	}
+
+	return key;
+}
+
+
+uint8_t kbd_key_down(uint8_t key) {
+	return (key_bitmap[key / 32] & (1u << (key % 32))) ? TRUE : FALSE;
+}
+
+
+void kbd_keys_clear() {
+	memset(key_bitmap, 0, sizeof(key_bitmap));
+	key_prefix = FALSE;
+	key_skip = 0;
+}
+
+
 //Reads command from PS/2 controller output port but discards it
 int kbd_discard() {
 	int timeout = TIMEOUT;
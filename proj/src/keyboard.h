@@ -16,6 +16,23 @@ int kbd_write(unsigned long command, int port);
 //Returns data read on success, KBD_ERROR otherwise
 int kbd_read();
 
+//Reads a scancode from the interrupt handler path, never sleeps
+//Checks the status register once and reads the output buffer if it's full
+//Returns scancode on success, KBD_NONE if there was no valid byte, KBD_ERROR if the ports couldn't be accessed
+int kbd_read_int();
+
+//Decodes one scancode set 1 byte and updates the pressed key bitmap
+//Keys are indexed by their make code, extended (0xE0 prefixed) keys by KEY_EXT(make code)
+//param pressed - set to TRUE for a make code, FALSE for a break code
+//Returns key index (0 - 255), -1 if the byte was a prefix and the key comes with the next byte
+int16_t kbd_decode(uint8_t scancode, uint8_t* pressed);
+
+//Returns TRUE if the key at index key is held down
+uint8_t kbd_key_down(uint8_t key);
+
+//Releases every key in the bitmap and drops a pending prefix
+void kbd_keys_clear();
+
 //Reads command from PS/2 controller output port but discards it
 int kbd_discard();
 
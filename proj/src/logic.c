@@ -2,17 +2,32 @@
 #include <minix/drivers.h>
 #include <minix/types.h>
 
+#include "mem.h"
+#include "arena.h"
+
 #define STB_IMAGE_IMPLEMENTATION
 #define STBI_ONLY_PNG
+//Decoder buffers come from the current state's arena, see logic_arena_enter()
+#define STBI_MALLOC(sz)						arena_current_alloc(sz)
+#define STBI_REALLOC_SIZED(p, oldsz, newsz)	arena_current_realloc(p, oldsz, newsz)
+#define STBI_FREE(p)						arena_current_free(p)
 #include "stb_image.h" //library for reading image files, namely PNG
 #include "LoLCOM.h"
 #include "video_gr.h"
 #include "logic.h"
 #include "helper.h"
 #include "i8042.h"
+#include "keyboard.h"
 #include "RTC.h"
 #include "mouse.h"
 #include "UART.h"
+#include "input.h"
+#include "render.h"
+#include "events.h"
+#include "flowfield.h"
+#include "ai.h"
+#include "projectile.h"
+#include "pngload.h"
 
 //Game state
 static game_state_t game = {{INIT_X, INIT_Y}, 0, 0, 0, 0, 0, FALSE, FALSE, MOVE_NONE, MENU};	//Game state
@@ -34,21 +49,109 @@ static font_t score = {0};
 static font_t serial_cooldown = {0};
 static font_t link_hp = {0};
 static const font_t font_base = {0};
+static surface_t glyph_atlas = {0};		//Font glyphs converted once, kept for the whole process
+
+//Sprite sheets compiled once per entity type, kept for the whole process
+static char sprite_paths[SPRITE_CACHE_N][64];
+static sprite_t sprite_cache[SPRITE_CACHE_N];
+static uint8_t sprite_cached = 0;
 
 //Image data
 static png_t serial_image = {0};
-static png_t menu[3] = {0};
-static png_t triforce = {0};
+static surface_t menu[3] = {0};			//Menu animation frames, converted once and kept for the whole process
+static surface_t triforce = {0};
+static int16_t menu_drawn_frame = -1;		//menu_frame on screen, -1 forces the menu to be drawn
+static int16_t menu_drawn_choice = -1;		//menu_choice on screen
 static png_t game_over_screen = {0};
 static const png_t png_base = {0};
 
+//Tilesets loaded since entering PLAYER1, maps sharing a tileset share it
+static char tileset_paths[TILESET_CACHE_N][64];
+static tileset_t tileset_cache[TILESET_CACHE_N];
+static uint8_t tileset_cached = 0;
+
+//Memory arenas, one per game state, everything a state decodes is dropped at once when it's entered again
+static arena_t state_arena[ARENA_N];
+static const char* arena_names[ARENA_N] = {"menu", "player1", "game over"};
+static const size_t arena_sizes[ARENA_N] = {ARENA_MENU_SIZE, ARENA_PLAYER1_SIZE, ARENA_GAMEOVER_SIZE};
+static const char* state_names[] = {"menu", "player1", "game over", "end"};
+
 //Other data
 static uint16_t scroll_line = 0; //Used for scrolling the map, current line being scrolled
 static uint8_t scroll_delay = 0; //Adds delay to scrolling without interfering with timer, still runs at 60hz
-static uint32_t last_keypress = 0; //Last keypress by the player
-static uint8_t packet[4]; //Mouse packets
+
+//Keys bound to each action, several keys can share one
+static const keybind_t keybinds[] = {
+	{W_MAKE, ACTION_UP},
+	{S_MAKE, ACTION_DOWN},
+	{A_MAKE, ACTION_LEFT},
+	{D_MAKE, ACTION_RIGHT},
+	{KEY_EXT(UP_MAKE), ACTION_UP},
+	{KEY_EXT(DOWN_MAKE), ACTION_DOWN},
+	{KEY_EXT(LEFT_MAKE), ACTION_LEFT},
+	{KEY_EXT(RIGHT_MAKE), ACTION_RIGHT},
+	{J_MAKE, ACTION_ATTACK},
+	{ENTER_MAKE, ACTION_CONFIRM},
+	{KEY_EXT(KP_ENTER_MAKE), ACTION_CONFIRM},
+	{ESC_MAKE, ACTION_BACK}
+};
+
+static uint8_t key_action[256];				//Action of every key index, built from keybinds
+static uint8_t movement_dirty = FALSE;		//A movement key changed, Link's movement is resolved on the next step
+static action_t last_move = ACTION_NONE;	//Latest movement action pressed, wins while it's held
 static uint8_t game_over_stage = 0;
 
+//Timed spawn data
+static uint32_t spawn_interval = SPAWN_TICKS;	//Event ticks between timed spawns on the current wave
+static uint16_t spawn_serial = 0;				//Id of the latest timed spawn, 0 is never used
+static uint8_t wave = 0;
+static uint8_t link_max_hp = 0;					//Hitpoints Link starts with, sword beams are fired at full health
+
+//Paths toward Link's tile shared by every enemy, rebuilt only when Link changes tile or the map changes
+static flowfield_t link_field;
+
+//Per channel (R, G, B) scale of the game over fade keyframes, 256 is full brightness
+//Channel sums of the pre-darkened Overworld32d1..d4 tilesets the fade used to load, over Overworld32's
+//Steps in between are interpolated
+static const uint16_t fade_keys[][COMPONENTS] = {
+	{256, 256, 256},
+	{263, 150,  86},
+	{244, 120,  60},
+	{173,  64,  22},
+	{ 57,  20,   7}
+};
+
+//Per channel scale of the damage flash, a palette rewrite so only indexed modes show it
+static const uint16_t flash_scale[COMPONENTS] = {384, 192, 192};
+static uint8_t flash_frames = 0;		//Frames the damage flash still lasts
+
+//Fixed timestep data
+static uint64_t sim_step_cycles = 0;	//TSC cycles per simulation step, 0 until logic_timing_init()
+static uint64_t sim_accumulator = 0;	//Real time not yet simulated, in TSC cycles
+static uint64_t sim_last = 0;			//TSC value at the previous call to logic_sim_task()
+static uint32_t frames_skipped = 0;		//Rendered frames dropped to catch up with the simulation
+static uint8_t sim_behind = FALSE;		//Simulation couldn't catch up on the last logic_sim_task()
+
+//Prints the memory used by the state being left, before anything is freed or loaded for the next one
+//Live memory must be the same every time a state is left for the same one, anything else is a leak
+static void logic_state_leave(state_t next) {
+
+	//Wall-clock time comes from the snapshot taken on the last update ended interrupt, no port I/O here
+	rtc_date_t date;
+
+	if(rtc_get_date(&date) == 0) {
+		printf("LoLCOM: RTC: %02X:%02X:%02X %s -> %s\n", date.hour, date.minute, date.second, state_names[game.state], state_names[next]);
+	}
+
+	mem_transition(state_names[game.state], state_names[next]);
+
+	//Input received in the old state isn't handled in the new one, keys whose break code was queued are released
+	mouse_ring_flush();
+	input_flush();
+	kbd_keys_clear();
+}
+
+
 void logic_change_state(game_event_t event) {
 
 	if(event == NA) {
@@ -58,38 +161,46 @@ void logic_change_state(game_event_t event) {
 	switch(game.state) {
 	case MENU:
 		if(event == MENUOPTION) {
+			logic_state_leave(PLAYER1);
 			game.state = PLAYER1;
-			logic_menu_free();
 			vg_change_buffering(game.menu_choice);
+			logic_arena_enter(PLAYER1);
 			if(logic_player1_init() != 0) {
 				panic("LoLCOM: player1_init: failed\n");
 			}
 			latest_event = NA;
 		} else if(event == EXITING) {
+			logic_state_leave(END);
 			game.state = END;
-			logic_menu_free();
 			latest_event = NA;
 		}
 		break;
 	case PLAYER1:
 		if(event == PLAYER1_QUIT) {
+			logic_state_leave(MENU);
 			game.state = MENU;
 			logic_player1_free();
+			logic_arena_enter(MENU);
 			if(logic_menu_init() != 0) {
 				panic("LoLCOM: menu_init: failed\n");
 			}
 			latest_event = NA;
 		} else if(event == DIED) {
+			logic_state_leave(GAMEOVER);
 			game.state = GAMEOVER;
+			flash_frames = 0;
 			game.death_f = TRUE;
+			logic_arena_enter(GAMEOVER);
 			game_over_stage = 0;
 			latest_event = NA;
 		}
 		break;
 	case GAMEOVER:
 		if(event == EXITING) {
+			logic_state_leave(MENU);
 			game.state = MENU;
 			logic_player1_free();
+			logic_arena_enter(MENU);
 			if(logic_menu_init() != 0) {
 				panic("LoLCOM: menu_init: failed\n");
 			}
@@ -101,26 +212,23 @@ void logic_change_state(game_event_t event) {
 }
 
 
-int8_t logic_handler(uint32_t data, uint8_t* pnumber, uint8_t* sync, uint8_t mode, origin_t origin) {
-
-	logic_change_state(latest_event);
+int8_t logic_handler(uint32_t data, uint8_t mode, origin_t origin) {
 
 	if(game.state == END) {
 		return 0;
 	}
 
 	switch(origin) {
-	case TIMER_INT:
-		logic_gameloop();
-		break;
 	case KBD_INT:
 		logic_kbd_input(data, mode);
 		break;
 	case MOUSE_INT:
-		logic_mouse_input(data, pnumber, sync, mode);
+		logic_mouse_input(data);
 		break;
 	case RTC_INT:
-		logic_rtc_handler();
+		if(logic_rtc_handler(data) != 0) {
+			return -1;
+		}
 		break;
 	case SERIAL_INT:
 		if(game.state == PLAYER1) {
@@ -135,6 +243,24 @@ int8_t logic_handler(uint32_t data, uint8_t* pnumber, uint8_t* sync, uint8_t mod
 }
 
 
+int8_t logic_input_drain() {
+
+	input_event_t event;
+
+	//Events are handled in the order the interrupts arrived, the drain stops at the first one requesting
+	//a state change so it applies between passes, the events after it are flushed by logic_change_state()
+	while(input_pop(&event) == 0) {
+		logic_handler(event.data, GAME, event.origin);
+
+		if(latest_event != NA) {
+			break;
+		}
+	}
+
+	return 0;
+}
+
+
 int8_t logic_player1_init() {
 
 	game = game_base;
@@ -142,7 +268,8 @@ int8_t logic_player1_init() {
 
 	scroll_line = 0;
 	scroll_delay = 0;
-	last_keypress = 0;
+	movement_dirty = FALSE;
+	last_move = ACTION_NONE;
 
 	currentmap = map_base;
 	nextmap = map_base;
@@ -170,6 +297,20 @@ int8_t logic_player1_init() {
 	}
 
 	entities[SWORD_I].coords = (point_t){entities[LINK_I].coords.x, entities[LINK_I].coords.y - TILESIZE};
+	link_max_hp = entities[LINK_I].hitpoints;
+
+	//Projectiles reuse pool slots, only their sprites are loaded
+	proj_clear();
+
+	sprite_t* rock = logic_lsprite(ROCK_SPRITE);
+	sprite_t* beam = logic_lsprite(BEAM_SPRITE);
+
+	if(rock == NULL || beam == NULL) {
+		return -1;
+	}
+
+	proj_set_sprite(PROJ_ROCK, rock);
+	proj_set_sprite(PROJ_BEAM, beam);
 
 	if(logic_lfont(&score) != 0) {
 		return -1;
@@ -181,15 +322,22 @@ int8_t logic_player1_init() {
 
 	strcpy(score.word, "SCORE:");
 	score.word_size = strlen("SCORE:");
-	logic_font_number(&score);
 
 	strcpy(link_hp.word, "HP:");
 	link_hp.word_size = strlen("HP:");
 	link_hp.number = entities[LINK_I].hitpoints;
-	logic_font_number(&link_hp);
 
-	rtc_read_register(RTC_STATUS_C); //Make sure nothing is stopping RTC interrupts
-	rtc_setalarm_s(SPAWN_RATE);
+	flow_invalidate(&link_field);
+
+	//Spawns and waves are timed by the RTC periodic interrupt, see logic_rtc_handler()
+	events_clear();
+	spawn_interval = SPAWN_TICKS;
+	spawn_serial = 0;
+	wave = 0;
+
+	if(events_push(spawn_interval, TEVENT_SPAWN, 0) != 0 || events_push(WAVE_TICKS, TEVENT_WAVE, 0) != 0) {
+		return -1;
+	}
 
 	return 0;
 }
@@ -197,19 +345,18 @@ int8_t logic_player1_init() {
 
 void logic_player1_free() {
 
-	stbi_image_free(currentmap.tileset);
-
-	if(game.changemap_f == FALSE) {
-		stbi_image_free(currentcopy.tileset);
-	}
+	//Tilesets and the game over images are dropped with their arenas by logic_arena_enter()
+	currentmap.tileset = NULL;
+	nextmap.tileset = NULL;
+	currentcopy.tileset = NULL;
+	game_over_screen = png_base;
 
-	stbi_image_free(score.fontdata);
-	stbi_image_free(link_hp.fontdata);
+	logic_font_free(&score);
+	logic_font_free(&link_hp);
 
-	size_t i;
-	for(i = 0; i < ENTITY_N; i++) {
-		stbi_image_free(entities[i].spritesheet);
-	}
+	//Quitting during a damage flash
+	flash_frames = 0;
+	vg_palette_reset();
 }
 
 
@@ -219,50 +366,287 @@ int8_t logic_menu_init() {
 	game.state = MENU;
 	game.menu_countdown = MENU_FRAMES;
 
-	menu[0] = png_base;
-	menu[1] = png_base;
-	menu[2] = png_base;
-	triforce = png_base;
+	menu_drawn_frame = -1;
+	menu_drawn_choice = -1;
+
+	//Menu images are only decoded the first time the menu is entered
+	if(triforce.pixels != NULL) {
+		return 0;
+	}
+
+	if(logic_lsurface(&menu[0], "Menu1.png", BLACK) != 0) {
+		return -1;
+	}
 
-	if(logic_lpng(&menu[0], "Menu1.png") != 0) {
+	if(logic_lsurface(&menu[1], "Menu2.png", BLACK) != 0) {
 		return -1;
 	}
 
-	if(logic_lpng(&menu[1], "Menu2.png") != 0) {
+	if(logic_lsurface(&menu[2], "Menu3.png", BLACK) != 0) {
 		return -1;
 	}
 
-	if(logic_lpng(&menu[2], "Menu3.png") != 0) {
+	if(logic_lsurface(&triforce, "Triforce.png", TRANSPARENT) != 0) {
 		return -1;
 	}
 
-	if(logic_lpng(&triforce, "Triforce.png") != 0) {
+	return 0;
+}
+
+
+int8_t logic_timing_init() {
+
+	uint64_t tsc_hz = tsc_calibrate();
+
+	if(tsc_hz == 0) {
+		printf("LoLCOM: timing: couldn't calibrate TSC, simulating one step per tick\n");
 		return -1;
 	}
 
+	sim_step_cycles = tsc_hz / SIM_HZ;
+
+	//Start half a step ahead so timer tick jitter doesn't alternate between 0 and 2 steps
+	sim_accumulator = sim_step_cycles / 2;
+	sim_last = rdtsc();
+	frames_skipped = 0;
+
+	return 0;
+}
+
+
+void logic_timing_print() {
+	printf("LoLCOM: timing: %d rendered frames skipped to keep simulation speed\n", frames_skipped);
+}
+
+
+int8_t logic_arena_init() {
+
+	size_t i;
+	for(i = 0; i < ARENA_N; i++) {
+		if(arena_init(&state_arena[i], arena_names[i], arena_sizes[i]) != 0) {
+			logic_arena_free();
+			return -1;
+		}
+	}
+
+	logic_arena_enter(MENU);
+
 	return 0;
 }
 
 
-void logic_menu_free() {
-	stbi_image_free(menu[0].image);
-	stbi_image_free(menu[1].image);
-	stbi_image_free(menu[2].image);
-	stbi_image_free(triforce.image);
+void logic_arena_enter(state_t state) {
+
+	if(state >= ARENA_N || state_arena[state].base == NULL) {
+		arena_use(NULL);
+		return;
+	}
+
+	//States are entered in the order MENU, PLAYER1, GAMEOVER: nothing from the entered state or the ones after it is used anymore
+	size_t i;
+	for(i = state; i < ARENA_N; i++) {
+		arena_reset(&state_arena[i]);
+	}
+
+	//Converted tilesets aren't in the arena, they're freed with it
+	if(state <= PLAYER1) {
+		for(i = 0; i < tileset_cached; i++) {
+			vg_surface_free(&tileset_cache[i].tiles);
+		}
+		tileset_cached = 0;
+	}
+
+	arena_use(&state_arena[state]);
+}
+
+
+void logic_arena_print() {
+
+	size_t i;
+	for(i = 0; i < ARENA_N; i++) {
+		if(state_arena[i].base != NULL) {
+			arena_report(&state_arena[i]);
+		}
+	}
+}
+
+
+void logic_arena_free() {
+
+	size_t i;
+	for(i = 0; i < ARENA_N; i++) {
+		arena_destroy(&state_arena[i]);
+	}
+}
+
+
+unsigned char* logic_arena_load(const char* path, int* x, int* y, mem_tag_t tag) {
+
+	png_file_t file;
+	png_image_t png = {0};
+	arena_t* arena = arena_current();
+	size_t mark = arena != NULL ? arena_mark(arena) : 0;
+	mem_tag_t previous = mem_tag(tag);
+
+	if(png_read(&file, path, arena_current_alloc, arena_current_free) == 0) {
+		png_decode(&png, &file, COMPONENTS);
+		png_file_free(&file);
+	}
+
+	//The file and the decoder's scratch buffers are dropped, only the image is kept at the old fill level
+	if(arena != NULL) {
+		if(png.pixels == NULL) {
+			arena_release(arena, mark);
+		} else png.pixels = arena_settle(arena, mark, png.pixels, (size_t) png.width * png.height * COMPONENTS);
+	}
+
+	mem_tag(previous);
+
+	*x = png.width;
+	*y = png.height;
+
+	return png.pixels;
+}
+
+
+int8_t logic_lsurface_path(surface_t* surface, const char* path, unsigned long key_color) {
+
+	png_file_t file;
+	png_image_t png;
+	int8_t ret = -1;
+	arena_t* arena = arena_current();
+	size_t mark = arena != NULL ? arena_mark(arena) : 0;
+	mem_tag_t previous = mem_tag(MEM_IMAGES);
+
+	//Decoded in the PNG's own layout, rows are converted straight into the surface
+	if(png_read(&file, path, arena_current_alloc, arena_current_free) == 0) {
+		if(png_decode(&png, &file, 0) == 0) {
+			ret = vg_surface_from_png(surface, &png, key_color);
+			png_image_free(&png);
+		}
+
+		png_file_free(&file);
+	}
+
+	//Nothing decoded here is kept, the arena drops it all at once
+	if(arena != NULL) {
+		arena_release(arena, mark);
+	}
+
+	mem_tag(previous);
+
+	return ret;
+}
+
+
+void logic_input_task(uint32_t arg) {
+
+	logic_input_drain();
+	logic_change_state(latest_event);
+}
+
+
+void logic_sim_task(uint32_t mouse_mode) {
+
+	//Not calibrated, simulation and rendering are locked to the task rate
+	if(sim_step_cycles == 0) {
+		logic_simulate(mouse_mode);
+		sim_behind = FALSE;
+		return;
+	}
+
+	uint64_t now = rdtsc();
+	sim_accumulator += now - sim_last;
+	sim_last = now;
+
+	//Never keep more backlog than can be caught up, the game slows down instead
+	if(sim_accumulator > SIM_MAX_BACKLOG * sim_step_cycles) {
+		sim_accumulator = SIM_MAX_BACKLOG * sim_step_cycles;
+	}
+
+	uint8_t steps = 0;
+	while(sim_accumulator >= sim_step_cycles && steps < SIM_MAX_STEPS) {
+		logic_simulate(mouse_mode);
+		sim_accumulator -= sim_step_cycles;
+		steps++;
+
+		if(game.state == END) {
+			return;
+		}
+	}
+
+	//Still behind, the next frame is skipped so there's more time to simulate
+	sim_behind = (sim_accumulator >= sim_step_cycles);
+}
+
+
+void logic_render_task(uint32_t arg) {
+
+	if(game.state == END) {
+		return;
+	}
+
+	if(sim_behind == TRUE) {
+		frames_skipped++;
+		return;
+	}
+
+	logic_updatedisplay();
+}
+
+
+//Counts down the damage flash, the palette is written back when it ends
+static void logic_damage_flash() {
+
+	if(flash_frames == 0) {
+		return;
+	}
+
+	flash_frames--;
+
+	if(flash_frames == 0) {
+		vg_palette_reset();
+	}
 }
 
 
-int8_t logic_gameloop() {
+int8_t logic_simulate(uint8_t mouse_mode) {
+
+	//Apply state changes requested by the previous step
+	logic_change_state(latest_event);
+
+	if(game.state == END) {
+		return 0;
+	}
+
+	//Mouse bytes received since the last step are decoded all at once
+	logic_mouse_decode(mouse_mode);
+	mouse_rate_tick();
+
+	//Keys held right now decide Link's movement, once per step
+	logic_resolve_movement();
 
 	if(game.state == MENU || game.state == GAMEOVER) {
 		logic_tick();
-		logic_updatedisplay();
 	} else if(game.state == PLAYER1) {
 		logic_tick();
 		logic_playercol();
+		logic_damage_flash();
 		logic_entitycol();
 		logic_update_sword();
-		logic_updatedisplay();
+
+		if(game.changemap_f == FALSE) {
+			proj_update(currentmap.collision);
+		}
+
+		if(game.changemap_f == TRUE) {
+			uint8_t ended = logic_scrollmap(game.changemap_dir);
+			if(ended == TRUE) {
+				game.changemap_f = FALSE;
+				currentmap = nextmap;
+				entities[LINK_I].speed_vect = (vector_t) {0, 0};
+			}
+		}
 	}
 
 	return 0;
@@ -284,9 +668,6 @@ void logic_tick() {
 		}
 	} else if(game.state == PLAYER1) {
 
-		logic_font_number(&score);
-		logic_font_number(&link_hp);
-
 		size_t i;
 		for(i = 0; i < ENTITY_N - 1; i++) {
 
@@ -322,8 +703,9 @@ void logic_tick() {
 					entities[i].movement = MOVE_NONE;
 					entities[i].speed_vect = (vector_t){0, 0};
 
+					//Resume movement if a movement key is still held
 					if(entities[i].isPC == TRUE) {
-						logic_kbd_input(last_keypress, GAME);
+						movement_dirty = TRUE;
 					}
 
 				} else if(entities[i].cooldown.iframes == 0 && entities[i].state == IFRAMES) {
@@ -344,7 +726,7 @@ void logic_tick() {
 		entities[LINK_I].speed_vect = (vector_t) {0, 0};
 
 		if(game.death_fade_count == 0) {
-			if(game_over_stage < 5) {
+			if(game_over_stage <= FADE_STEPS) {
 				logic_game_over_fade(game_over_stage);
 				game_over_stage++;
 			} else game.death_f = FALSE;
@@ -439,6 +821,24 @@ void logic_update_movement(entity_t* entity) {
 }
 
 
+//Speed vector of magnitude speed toward direction, {0, 0} for MOVE_NONE
+static vector_t logic_dir_vect(event_t direction, int16_t speed) {
+
+	switch(direction) {
+	case MOVE_UP:
+		return (vector_t){0, -speed};
+	case MOVE_DOWN:
+		return (vector_t){0, speed};
+	case MOVE_LEFT:
+		return (vector_t){-speed, 0};
+	case MOVE_RIGHT:
+		return (vector_t){speed, 0};
+	default:
+		return (vector_t){0, 0};
+	}
+}
+
+
 int8_t logic_playercol() {
 
 	//Update player sprite
@@ -450,6 +850,7 @@ int8_t logic_playercol() {
 	}
 
 	uint8_t entity_col = FALSE;
+	vector_t hit_vect = {0, 0};	//Speed of whatever hit Link
 	size_t i = 0;
 
 	//Check for sprite collisions if player is in NORMAL state
@@ -460,17 +861,28 @@ int8_t logic_playercol() {
 			}
 
 			if(entity_col == TRUE) {
+				hit_vect = entities[i].speed_vect;
 				break;
 			}
 		}
+
+		if(entity_col == FALSE) {
+			int16_t p = proj_hit(entities[LINK_I].coords, TRUE);
+
+			if(p != PROJ_NONE) {
+				entity_col = TRUE;
+				hit_vect = logic_dir_vect(proj_direction(p), MAX_SPEED / 2);
+				proj_kill(p);
+			}
+		}
 	}
 
 	//Handle sprite collisions
 	if(entity_col == TRUE) {
 
 		if(entities[LINK_I].speed_vect.x == 0 && entities[LINK_I].speed_vect.y == 0) {
-			entities[LINK_I].speed_vect.x = 2 * entities[i].speed_vect.x;
-			entities[LINK_I].speed_vect.y = 2 * entities[i].speed_vect.y;
+			entities[LINK_I].speed_vect.x = 2 * hit_vect.x;
+			entities[LINK_I].speed_vect.y = 2 * hit_vect.y;
 		} else {
 			entities[LINK_I].speed_vect.x *= -2;
 			entities[LINK_I].speed_vect.y *= -2;
@@ -482,6 +894,11 @@ int8_t logic_playercol() {
 		entities[LINK_I].cooldown.knockback = KNOCK_FRAMES;
 		entities[LINK_I].cooldown.iframes = I_FRAMES;
 
+		//O(256) in indexed modes, RGB modes would have to rescale the tileset and only show the i-frame sprites
+		if(vg_indexed() && vg_palette_scale(flash_scale) == 0) {
+			flash_frames = FLASH_FRAMES;
+		}
+
 		entities[SWORD_I].state = NORMAL;
 		entities[SWORD_I].hitpoints = 0;
 		entities[SWORD_I].cooldown.attack = 0;
@@ -530,6 +947,9 @@ int8_t logic_entitycol() {
 		return 0;
 	}
 
+	point_t link_center = {entities[LINK_I].coords.x + TILESIZE / 2, entities[LINK_I].coords.y + TILESIZE / 2};
+	flow_update(&link_field, currentmap.collision, logic_currtile(link_center));
+
 	size_t i;
 	for(i = 1; i < ENTITY_N - 1; i++) {
 
@@ -537,33 +957,32 @@ int8_t logic_entitycol() {
 			uint8_t entity_col = FALSE;
 			uint8_t map_col = FALSE;
 
-			if(entities[i].cooldown.move == 0 && entities[i].state == NORMAL) {
-				logic_enemy_move(&entities[i]);
+			if(entities[i].state == NORMAL) {
+				logic_enemy_behave(&entities[i]);
 			}
 
 			//Update entity sprite
 			logic_currsprite(&entities[i]);
 
+			event_t hit_dir = entities[SWORD_I].movement;
+
 			if(entities[i].state == NORMAL && entities[SWORD_I].hitpoints != 0) {
 				entity_col = logic_swordcol(entities[i]);
 			}
 
+			if(entities[i].state == NORMAL && entity_col == FALSE) {
+				int16_t p = proj_hit(entities[i].coords, FALSE);
+
+				if(p != PROJ_NONE) {
+					entity_col = TRUE;
+					hit_dir = proj_direction(p);
+					proj_kill(p);
+				}
+			}
+
 			if(entity_col == TRUE) {
-				switch(entities[SWORD_I].movement) {
-				case MOVE_UP:
-					entities[i].speed_vect = (vector_t){0, -MAX_SPEED};
-					break;
-				case MOVE_DOWN:
-					entities[i].speed_vect = (vector_t){0, MAX_SPEED};
-					break;
-				case MOVE_LEFT:
-					entities[i].speed_vect = (vector_t){-MAX_SPEED, 0};
-					break;
-				case MOVE_RIGHT:
-					entities[i].speed_vect = (vector_t){MAX_SPEED, 0};
-					break;
-				default:
-					break;
+				if(hit_dir != MOVE_NONE) {
+					entities[i].speed_vect = logic_dir_vect(hit_dir, MAX_SPEED);
 				}
 
 				entities[i].speed_vect.x = clamp_int16(entities[i].speed_vect.x, -MAX_SPEED, MAX_SPEED);
@@ -573,6 +992,7 @@ int8_t logic_entitycol() {
 				entities[i].cooldown.iframes = I_FRAMES;
 
 				entities[i].state = KNOCKBACK_DMG;
+				ai_reset(&entities[i].ai);
 
 				entities[i].hitpoints--;
 				if(entities[i].hitpoints != 0) {
@@ -587,6 +1007,7 @@ int8_t logic_entitycol() {
 
 			//Check for map collisions
 			map_col = logic_tilecolcycle(entities[i]);
+			entities[i].ai.blocked = map_col;
 
 			//Handle map collision
 			if(map_col == FALSE) {
@@ -604,8 +1025,7 @@ int8_t logic_entitycol() {
 
 void logic_reset_monster(entity_t* entity) {
 
-	stbi_image_free(entity->spritesheet);
-	entity->spritesheet = NULL;
+	entity->sprite = NULL;
 
 	entity->walk_anim_f = FALSE;
 	entity->speed_vect = (vector_t) {0, 0};
@@ -670,7 +1090,8 @@ uint8_t logic_aabbcol(entity_t entity) {
 }
 
 
-void logic_enemy_move(entity_t* entity) {
+//Picks a random direction, or stops, once per cooldown.move
+static void logic_enemy_wander(entity_t* entity) {
 
 	uint32_t move = rand() % 5;
 
@@ -699,6 +1120,100 @@ void logic_enemy_move(entity_t* entity) {
 }
 
 
+void logic_enemy_behave(entity_t* entity) {
+
+	point_t center = {entity->coords.x + TILESIZE / 2, entity->coords.y + TILESIZE / 2};
+
+	switch(ai_step(&entity->ai, logic_currtile(center), link_field.target)) {
+	case MOTION_CHASE:
+		logic_enemy_move(entity);
+		break;
+	case MOTION_DASH:
+		entity->speed_vect = logic_dir_vect(entity->ai.facing, entity->ai.dash_speed);
+		break;
+	case MOTION_SHOOT:
+		entity->speed_vect = (vector_t){0, 0};
+		proj_spawn(PROJ_ROCK, entity->coords, entity->ai.facing, ROCK_SPEED, ROCK_FRAMES, TRUE);
+		break;
+	case MOTION_AIM:
+		entity->speed_vect = (vector_t){0, 0};
+		entity->currsprite = entity->ai.facing + entity->tilesperline * entity->walk_anim_f;
+		break;
+	case MOTION_STAND:
+		entity->speed_vect = (vector_t){0, 0};
+		break;
+	default:
+		if(entity->cooldown.move == 0) {
+			logic_enemy_wander(entity);
+		}
+		break;
+	}
+}
+
+
+void logic_enemy_move(entity_t* entity) {
+
+	//The tile under the entity's center decides where it goes next
+	point_t center = {entity->coords.x + TILESIZE / 2, entity->coords.y + TILESIZE / 2};
+	point_t tile = logic_currtile(center);
+	event_t dir = flow_dir(&link_field, tile);
+
+	if(dir == MOVE_NONE) {
+
+		//Sharing Link's tile, close in along the axis furthest away
+		if(tile.x == link_field.target.x && tile.y == link_field.target.y) {
+			int16_t dx = entities[LINK_I].coords.x - entity->coords.x;
+			int16_t dy = entities[LINK_I].coords.y - entity->coords.y;
+
+			if(abs(dx) >= abs(dy)) {
+				entity->speed_vect = (vector_t){clamp_int16(dx, -entity->speed, entity->speed), 0};
+			} else {
+				entity->speed_vect = (vector_t){0, clamp_int16(dy, -entity->speed, entity->speed)};
+			}
+
+		//No path to Link from here
+		} else if(entity->cooldown.move == 0) {
+			logic_enemy_wander(entity);
+		}
+
+		return;
+	}
+
+	//Line up with the tile before turning so the entity doesn't clip the corners of blocked tiles
+	int16_t dx = tile.x * TILESIZE - entity->coords.x;
+	int16_t dy = tile.y * TILESIZE - entity->coords.y;
+
+	entity->speed_vect = (vector_t){0, 0};
+
+	if((dir == MOVE_UP || dir == MOVE_DOWN) && dx != 0) {
+		entity->speed_vect.x = clamp_int16(dx, -entity->speed, entity->speed);
+		return;
+	}
+
+	if((dir == MOVE_LEFT || dir == MOVE_RIGHT) && dy != 0) {
+		entity->speed_vect.y = clamp_int16(dy, -entity->speed, entity->speed);
+		return;
+	}
+
+	switch(dir) {
+	case MOVE_UP:
+		entity->speed_vect.y = -entity->speed;
+		break;
+	case MOVE_DOWN:
+		entity->speed_vect.y = entity->speed;
+		break;
+	case MOVE_LEFT:
+		entity->speed_vect.x = -entity->speed;
+		break;
+	case MOVE_RIGHT:
+		entity->speed_vect.x = entity->speed;
+		break;
+	default:
+		break;
+	}
+}
+
+
 uint8_t logic_tilecolcycle(entity_t entity) {
 
 	uint8_t result_1, result_2, result_3, result_4, result_5, result_6, result_7, result_8;
@@ -944,14 +1459,15 @@ int8_t logic_lmap(const unsigned char* filename, map_t* map) {
 			map->ntiles = parse_ulong(line, 10);
 			flags = 0;
 		} else if(flags == TILESET) {
-			int x, y, comp;
-			map->tileset = stbi_load(line, &x, &y, &comp, COMPONENTS);
+			tileset_t* tileset = logic_ltileset(line);
 
-			if(map->tileset == NULL) {
+			if(tileset == NULL) {
 				printf("LoLCOM: logic_lmap: couldn't open tileset PNG\n");
+				mem_free(line);
+				fclose(mapfile);
 				return -1;
 			}
-			map->tileset_width = x;
+			map->tileset = tileset;
 			flags = 0;
 		}
 
@@ -971,12 +1487,54 @@ int8_t logic_lmap(const unsigned char* filename, map_t* map) {
 
 	} while(nread != -1);
 
+	mem_free(line);
 	fclose(mapfile);
 	return 0;
 }
 
 
-point_t logic_currtile(point_t entity) {
+tileset_t* logic_ltileset(const char* path) {
+
+	size_t i;
+	for(i = 0; i < tileset_cached; i++) {
+		if(strcmp(tileset_paths[i], path) == 0) {
+			return &tileset_cache[i];
+		}
+	}
+
+	if(tileset_cached == TILESET_CACHE_N) {
+		printf("LoLCOM: tileset: tileset cache is full\n");
+		return NULL;
+	}
+
+	int x, y;
+	tileset_t* tileset = &tileset_cache[tileset_cached];
+
+	tileset->source.image = logic_arena_load(path, &x, &y, MEM_MAPS);
+
+	if(tileset->source.image == NULL) {
+		return NULL;
+	}
+
+	tileset->source.image_width = x;
+	tileset->source.image_height = y;
+
+	//Map tiles are drawn every frame, converted once here they're copied a row at a time
+	//Tiles are drawn first over a cleared screen, TRANSPARENT pixels can be stored as black
+	if(vg_surface_from_rgb(&tileset->tiles, tileset->source.image, x, y, BLACK) != 0) {
+		return NULL;
+	}
+
+	strncpy(tileset_paths[tileset_cached], path, sizeof(tileset_paths[0]) - 1);
+	tileset_paths[tileset_cached][sizeof(tileset_paths[0]) - 1] = 0;
+
+	tileset_cached++;
+
+	return tileset;
+}
+
+
+point_t logic_currtile(point_t entity) {
 	point_t tilecoords;
 
 	tilecoords.x = entity.x / TILESIZE;
@@ -987,8 +1545,17 @@ point_t logic_currtile(point_t entity) {
 
 int8_t logic_clear_enemies() {
 
-	rtc_read_register(RTC_STATUS_C); //Make sure nothing is stopping RTC interrupts
-	rtc_setalarm_s(SPAWN_RATE);
+	flow_invalidate(&link_field);
+	proj_clear();
+
+	//A new screen restarts the spawn countdown, the wave keeps going
+	events_cancel(TEVENT_SPAWN);
+	events_cancel(TEVENT_DESPAWN);
+
+	if(events_push(spawn_interval, TEVENT_SPAWN, 0) != 0) {
+		printf("LoLCOM: clear_enemies: couldn't schedule the next spawn\n");
+		return -1;
+	}
 
 	size_t i;
 	for(i = 1; i < ENTITY_N - 1; i++) {
@@ -999,18 +1566,54 @@ int8_t logic_clear_enemies() {
 }
 
 
-int8_t logic_rtc_handler() {
+int8_t logic_rtc_handler(uint32_t regC) {
 
-	uint32_t regC;
-	regC = rtc_read_register(RTC_STATUS_C);
+	if(regC == RTC_ERROR || (regC & PIF) == 0 || game.state != PLAYER1) {
+		return 0;
+	}
 
-	if(game.state == PLAYER1) {
+	events_tick();
 
-		if(logic_rtc_spawn("NULL") != 0) {
-			return -1;
+	tevent_t event;
+	while(events_pop_due(&event) == 0) {
+
+		switch(event.type) {
+		case TEVENT_SPAWN:
+			//Re-armed first, spawning stops for good if this event is lost
+			if(events_push(spawn_interval, TEVENT_SPAWN, 0) != 0) {
+				printf("LoLCOM: rtc_handler: couldn't schedule the next spawn\n");
+				return -1;
+			}
+
+			if(logic_rtc_spawn("NULL") != 0) {
+				return -1;
+			}
+			break;
+		case TEVENT_DESPAWN: {
+			//arg holds the entity index and the id of the spawn, the slot may have been reused since
+			entity_t* entity = &entities[event.arg & 0xFF];
+
+			if(entity->hitpoints != 0 && entity->spawn_id == (event.arg >> 8)) {
+				entity->hitpoints = 0;
+			}
+			break;
 		}
+		case TEVENT_WAVE:
+			wave++;
+			spawn_interval = spawn_interval * WAVE_SPEEDUP / 100;
+
+			if(spawn_interval < SPAWN_MIN_TICKS) {
+				spawn_interval = SPAWN_MIN_TICKS;
+			}
 
-		rtc_setalarm_s(SPAWN_RATE);
+			if(events_push(WAVE_TICKS, TEVENT_WAVE, 0) != 0) {
+				printf("LoLCOM: rtc_handler: couldn't schedule the next wave\n");
+				return -1;
+			}
+			break;
+		default:
+			break;
+		}
 	}
 
 	return 0;
@@ -1063,12 +1666,39 @@ int8_t logic_rtc_spawn(unsigned char* enemy_type) {
 	if(i < ENTITY_N - 4) {
 		entities[i].coords.x = enemy_coords.x;
 		entities[i].coords.y = enemy_coords.y;
+
+		spawn_serial++;
+		if(spawn_serial == 0) {
+			spawn_serial++;
+		}
+
+		entities[i].spawn_id = spawn_serial;
+
+		//Spawn and wave events always find a slot, without one the enemy just isn't despawned
+		if(events_free() > EVENTS_RESERVED) {
+			events_push(DESPAWN_TICKS, TEVENT_DESPAWN, ((uint32_t) spawn_serial << 8) | i);
+		} else {
+			printf("LoLCOM: rtc_spawn: no room to schedule a despawn\n");
+		}
 	}
 
 	return 0;
 }
 
 
+//Queues every tile of the current map, drawn with its top left corner at coords
+static void logic_queue_map(point_t coords) {
+
+	uint8_t i, j;
+	for (i = 0; i < MHEIGHT; i++) {
+		for (j = 0; j < MWIDTH; j++) {
+			point_t tile_coords = (point_t){coords.x + j * TILESIZE, coords.y + i * TILESIZE};
+			render_tile(LAYER_MAP, &currentmap.tileset->tiles, currentmap.tilesperline, currentmap.map[j + i * MWIDTH], tile_coords);
+		}
+	}
+}
+
+
 int8_t logic_updatedisplay() {
 
 	if(game.state == PLAYER1) {
@@ -1083,52 +1713,46 @@ int8_t logic_updatedisplay() {
 		map_coords.x = topleft_x;
 		map_coords.y = topleft_y + STATUSBAR_H;
 
-		if(game.changemap_f == TRUE) {
-			uint8_t ended = logic_scrollmap(game.changemap_dir);
-			if(ended == TRUE) {
-				game.changemap_f = FALSE;
-				currentmap = nextmap;
-				entities[LINK_I].speed_vect = (vector_t) {0, 0};
-			}
-		}
+		render_begin();
 
-		vg_draw_map(map_coords);
+		logic_queue_map(map_coords);
 
 		size_t i;
 		point_t scorecoords = (point_t){topleft_x, topleft_y + FONT_Y_ADJUST};
-		for(i = 0; i < score.word_size; i++) {
-			if(score.word[i] != 0) {
-				vg_font(scorecoords, score.fontdata_width, score.tilesperline, score.fontdata, score.word[i] - FONT_START);
-				scorecoords.x += FONT_W + score.coords.x;
-			} else break;
-		}
+		logic_font_render(&score);
+		render_surface(LAYER_HUD, &score.run, score.run_width, FONT_H, scorecoords);
 
 		point_t hpcoords = (point_t){topleft_x + 16 * TILESIZE - FONT_X_ADJUST, topleft_y + FONT_Y_ADJUST};
-		for(i = 0; i < link_hp.word_size; i++) {
-			if(link_hp.word[i] != 0) {
-				vg_font(hpcoords, link_hp.fontdata_width, link_hp.tilesperline, link_hp.fontdata, link_hp.word[i] - FONT_START);
-				hpcoords.x += FONT_W + link_hp.coords.x;
-			} else break;
-		}
+		logic_font_render(&link_hp);
+		render_surface(LAYER_HUD, &link_hp.run, link_hp.run_width, FONT_H, hpcoords);
 
 		if(game.changemap_f == TRUE) {
 			sprite_coords.x = map_coords.x + entities[LINK_I].coords.x;
 			sprite_coords.y = map_coords.y + entities[LINK_I].coords.y;
-			vg_tile(sprite_coords, entities[LINK_I].spritesheet_width, entities[LINK_I].tilesperline, entities[LINK_I].spritesheet, entities[LINK_I].currsprite);
+			render_sprite(LAYER_ENTITY, entities[LINK_I].sprite, entities[LINK_I].currsprite, sprite_coords);
 		} else {
 			for(i = 0; i < ENTITY_N; i++) {
 
 				if(entities[i].hitpoints != 0) {
 					sprite_coords.x = map_coords.x + entities[i].coords.x;
 					sprite_coords.y = map_coords.y + entities[i].coords.y;
-					vg_tile(sprite_coords, entities[i].spritesheet_width, entities[i].tilesperline, entities[i].spritesheet, entities[i].currsprite);
+					render_sprite(i == SWORD_I ? LAYER_WEAPON : LAYER_ENTITY, entities[i].sprite, entities[i].currsprite, sprite_coords);
 				}
 			}
+
+			proj_queue(map_coords);
 		}
 
+		render_flush();
+
 		vg_refresh();
 	} else if(game.state == MENU) {
 
+		//Screen already shows this frame and choice, nothing to draw or flip
+		if(game.menu_frame == menu_drawn_frame && game.menu_choice == menu_drawn_choice) {
+			return 0;
+		}
+
 		vg_clear();
 
 		uint16_t topleft_x, topleft_y;
@@ -1136,12 +1760,15 @@ int8_t logic_updatedisplay() {
 		vg_topleft(&topleft_x, &topleft_y);
 
 		if(game.menu_frame >= 0 && game.menu_frame < 3) {
-			vg_png((point_t){topleft_x, topleft_y}, menu[game.menu_frame].image_width, menu[game.menu_frame].image_height, menu[game.menu_frame].image);
+			vg_blit((point_t){topleft_x, topleft_y}, &menu[game.menu_frame], menu[game.menu_frame].width, menu[game.menu_frame].height);
 		}
 
-		vg_png((point_t){topleft_x + TRIFORCE_X, topleft_y + TRIFORCE_Y + game.menu_choice * TRIFORCE_ADJUST}, triforce.image_width, triforce.image_height, triforce.image);
+		vg_blit_keyed((point_t){topleft_x + TRIFORCE_X, topleft_y + TRIFORCE_Y + game.menu_choice * TRIFORCE_ADJUST}, &triforce);
 
 		vg_refresh();
+
+		menu_drawn_frame = game.menu_frame;
+		menu_drawn_choice = game.menu_choice;
 	} else if(game.state == GAMEOVER) {
 		vg_clear();
 
@@ -1150,7 +1777,7 @@ int8_t logic_updatedisplay() {
 
 		vg_topleft(&topleft_x, &topleft_y);
 
-		if(game_over_stage > 4) {
+		if(game_over_stage > FADE_STEPS) {
 			vg_png((point_t){topleft_x, topleft_y}, game_over_screen.image_width, game_over_screen.image_height, game_over_screen.image);
 		} else {
 
@@ -1158,11 +1785,15 @@ int8_t logic_updatedisplay() {
 			map_coords.x = topleft_x;
 			map_coords.y = topleft_y + STATUSBAR_H;
 
-			vg_draw_map(map_coords);
+			render_begin();
+
+			logic_queue_map(map_coords);
 
 			sprite_coords.x = map_coords.x + entities[LINK_I].coords.x;
 			sprite_coords.y = map_coords.y + entities[LINK_I].coords.y;
-			vg_tile(sprite_coords, entities[LINK_I].spritesheet_width, entities[LINK_I].tilesperline, entities[LINK_I].spritesheet, entities[LINK_I].currsprite);
+			render_sprite(LAYER_ENTITY, entities[LINK_I].sprite, entities[LINK_I].currsprite, sprite_coords);
+
+			render_flush();
 
 		}
 
@@ -1175,28 +1806,35 @@ int8_t logic_updatedisplay() {
 
 int8_t logic_game_over_fade(uint8_t stage) {
 
-	if(stage < 4) {
-
-		char path[64];
+	if(stage < FADE_STEPS) {
 
-		strcpy(path, OVER_PATH);
+		//Position of this step between the keyframes, in 1/256 units
+		uint16_t nkeys = sizeof(fade_keys) / sizeof(fade_keys[0]);
+		uint32_t position = (stage + 1) * (nkeys - 1) * 256 / FADE_STEPS;
+		uint16_t key = position / 256;
+		uint16_t frac = position % 256;
 
-		char concat[1];
+		uint16_t scale[COMPONENTS];
 
-		sprintf(concat, "%d", stage + 1);
-		strcat(path, concat);
-		strcat(path, ".png");
-
-		int x, y, comp;
-		stbi_image_free(currentmap.tileset);
-		currentmap.tileset = stbi_load(path, &x, &y, &comp, COMPONENTS);
+		size_t i;
+		for(i = 0; i < COMPONENTS; i++) {
+			if(key >= nkeys - 1) {
+				scale[i] = fade_keys[nkeys - 1][i];
+			} else {
+				scale[i] = (fade_keys[key][i] * (256 - frac) + fade_keys[key + 1][i] * frac) / 256;
+			}
+		}
 
-		if(currentmap.tileset == NULL) {
-			printf("LoLCOM: logic_lmap: couldn't open tileset PNG\n");
-			return -1;
+		//Indexed modes fade the palette, the tileset stays untouched
+		if(vg_indexed()) {
+			return vg_palette_scale(scale);
 		}
-		currentmap.tileset_width = x;
+
+		//Converted again from the untouched RGB tileset once per step, frames keep copying tile rows
+		return vg_surface_fade(&currentmap.tileset->tiles, currentmap.tileset->source.image, scale, BLACK);
 	} else {
+		vg_palette_reset();
+
 		if(logic_lpng(&game_over_screen, "GameOver.png") != 0) {
 			return -1;
 		}
@@ -1329,180 +1967,216 @@ int8_t logic_kbd_input(uint32_t scancode, uint8_t origin) {
 		return 0;
 	}
 
-	if(game.state == PLAYER1 && game.changemap_f != TRUE) {
+	uint8_t pressed;
+	int16_t key = kbd_decode(scancode, &pressed);
 
-		if(scancode == ESC_MAKE) {
-			latest_event = PLAYER1_QUIT;
-			return 0;
+	//Prefix byte, the key comes next
+	if(key < 0) {
+		return 0;
+	}
+
+	logic_action(key_action[key], pressed);
+
+	return 0;
+}
+
+
+void logic_keybinds_init() {
+
+	memset(key_action, ACTION_NONE, sizeof(key_action));
+
+	size_t i;
+	for(i = 0; i < sizeof(keybinds) / sizeof(keybinds[0]); i++) {
+		key_action[keybinds[i].key] = keybinds[i].action;
+	}
+
+	kbd_keys_clear();
+}
+
+
+//Returns TRUE if any key bound to action is held down
+static uint8_t logic_action_down(action_t action) {
+
+	size_t i;
+	for(i = 0; i < sizeof(keybinds) / sizeof(keybinds[0]); i++) {
+		if(keybinds[i].action == action && kbd_key_down(keybinds[i].key)) {
+			return TRUE;
 		}
+	}
 
-		if(scancode == W_MAKE || scancode == S_MAKE || scancode == A_MAKE || scancode == D_MAKE ||
-				scancode == BREAK(W_MAKE) || scancode == BREAK(S_MAKE) || scancode == BREAK(A_MAKE) || scancode == BREAK(D_MAKE)) {
-			last_keypress = scancode;
+	return FALSE;
+}
+
+
+void logic_action(action_t action, uint8_t pressed) {
+
+	if(action == ACTION_NONE) {
+		return;
+	}
+
+	switch(game.state) {
+	case PLAYER1:
+		if(action >= ACTION_UP && action <= ACTION_RIGHT) {
+			if(pressed == TRUE) {
+				last_move = action;
+			}
+			movement_dirty = TRUE;
+			break;
 		}
 
-		if(entities[LINK_I].state != KNOCKBACK_DMG) {
+		if(game.changemap_f == TRUE) {
+			break;
+		}
 
-			switch(scancode) {
-			case W_MAKE:
-				entities[LINK_I].movement = MOVE_UP;
-				entities[LINK_I].speed_vect = (vector_t){0, -entities[LINK_I].speed};
-				break;
-			case S_MAKE:
-				entities[LINK_I].movement = MOVE_DOWN;
-				entities[LINK_I].speed_vect = (vector_t){0, entities[LINK_I].speed};
-				break;
-			case A_MAKE:
-				entities[LINK_I].movement = MOVE_LEFT;
-				entities[LINK_I].speed_vect = (vector_t){-entities[LINK_I].speed, 0};
-				break;
-			case D_MAKE:
-				entities[LINK_I].movement = MOVE_RIGHT;
-				entities[LINK_I].speed_vect = (vector_t){entities[LINK_I].speed, 0};
-				break;
-			case J_MAKE:
+		if(action == ACTION_BACK && pressed == TRUE) {
+			latest_event = PLAYER1_QUIT;
+		} else if(action == ACTION_ATTACK && entities[LINK_I].state != KNOCKBACK_DMG) {
+			if(pressed == TRUE) {
 				if(entities[SWORD_I].state != ATTACKING && entities[SWORD_I].cooldown.attack == 0 && entities[LINK_I].state == NORMAL) {
 					entities[SWORD_I].hitpoints = 1;
 					entities[SWORD_I].cooldown.attack = SWORD_FRAMES;
 					entities[SWORD_I].state = ATTACKING;
-				}
-				break;
-			default:
-				break;
-			}
 
-			if((scancode == BREAK(W_MAKE) && entities[LINK_I].movement == MOVE_UP) || (scancode == BREAK(S_MAKE) && entities[LINK_I].movement == MOVE_DOWN) ||
-					(scancode == BREAK(A_MAKE) && entities[LINK_I].movement == MOVE_LEFT) || (scancode == BREAK(D_MAKE) && entities[LINK_I].movement == MOVE_RIGHT)) {
-				entities[LINK_I].movement = MOVE_NONE;
-				entities[LINK_I].speed_vect = (vector_t){0, 0};
-				last_keypress = 0;
-			}
-
-			if(scancode == BREAK(J_MAKE) && entities[SWORD_I].state == ATTACKING) {
+					//At full health the sword also fires a beam, one at a time
+					if(entities[LINK_I].hitpoints == link_max_hp && proj_alive(PROJ_BEAM, FALSE) == FALSE) {
+						proj_spawn(PROJ_BEAM, entities[SWORD_I].coords, entities[SWORD_I].movement, BEAM_SPEED, BEAM_FRAMES, FALSE);
+					}
+				}
+			} else if(entities[SWORD_I].state == ATTACKING) {
 				entities[SWORD_I].state = NORMAL;
 			}
 		}
-	} else if(game.state == MENU) {
-		if(scancode == W_MAKE) {
+		break;
+	case MENU:
+		if(pressed == FALSE) {
+			break;
+		}
+
+		if(action == ACTION_UP) {
 			if(game.menu_choice == 0) {
 				game.menu_choice = MENU_MAX;
 			} else game.menu_choice--;
-		} else if(scancode == S_MAKE) {
+		} else if(action == ACTION_DOWN) {
 			if(game.menu_choice == MENU_MAX) {
 				game.menu_choice = 0;
 			} else game.menu_choice++;
-		} else if(scancode == ENTER_MAKE) {
+		} else if(action == ACTION_CONFIRM) {
 			latest_event = MENUOPTION;
-		} else if(scancode == ESC_MAKE) {
+		} else if(action == ACTION_BACK) {
 			latest_event = EXITING;
 		}
-	} else if(game.state == GAMEOVER) {
-		if(game.death_f == FALSE) {
-			if(scancode == BREAK(ESC_MAKE) || scancode == BREAK(ENTER_MAKE)) {
-				latest_event = EXITING;
-			}
+		break;
+	case GAMEOVER:
+		if(game.death_f == FALSE && pressed == FALSE && (action == ACTION_CONFIRM || action == ACTION_BACK)) {
+			latest_event = EXITING;
 		}
+		break;
+	default:
+		break;
 	}
-
-	return 0;
 }
 
 
-uint8_t logic_check_end() {
-	if(game.state == END) {
-		return TRUE;
-	} else return FALSE;
-}
-
+void logic_resolve_movement() {
 
-int8_t logic_mouse_input(uint32_t data, uint8_t* pnumber, uint8_t* sync, uint8_t mode) {
+	if(movement_dirty == FALSE || game.state != PLAYER1) {
+		return;
+	}
 
-	if(mode != MOUSE_SCROLL_EX) {
+	//Movement waits for scrolling and knockback to end, the key state is read then
+	if(game.changemap_f == TRUE || entities[LINK_I].state == KNOCKBACK_DMG) {
+		return;
+	}
 
-		//Reset pnumber if needed
-		if(*pnumber == 3) {
-			*pnumber = 0;
-		}
+	movement_dirty = FALSE;
 
-		packet[*pnumber] = data;
+	//Latest key pressed wins, otherwise any movement key still held
+	action_t move = ACTION_NONE;
 
-		if((packet[*pnumber] & SYNC_BIT) && *sync == 0) {
-			*pnumber = 0;
-			*sync = 1;
+	if(last_move != ACTION_NONE && logic_action_down(last_move)) {
+		move = last_move;
+	} else {
+		action_t action;
+		for(action = ACTION_UP; action <= ACTION_RIGHT; action++) {
+			if(logic_action_down(action)) {
+				move = action;
+				break;
+			}
 		}
+	}
 
-		(*pnumber)++;
+	uint8_t speed = entities[LINK_I].speed;
 
-		if((packet[0] & SYNC_BIT) == 0) {
-			*sync = 0;
-		}
+	switch(move) {
+	case ACTION_UP:
+		entities[LINK_I].movement = MOVE_UP;
+		entities[LINK_I].speed_vect = (vector_t){0, -speed};
+		break;
+	case ACTION_DOWN:
+		entities[LINK_I].movement = MOVE_DOWN;
+		entities[LINK_I].speed_vect = (vector_t){0, speed};
+		break;
+	case ACTION_LEFT:
+		entities[LINK_I].movement = MOVE_LEFT;
+		entities[LINK_I].speed_vect = (vector_t){-speed, 0};
+		break;
+	case ACTION_RIGHT:
+		entities[LINK_I].movement = MOVE_RIGHT;
+		entities[LINK_I].speed_vect = (vector_t){speed, 0};
+		break;
+	default:
+		entities[LINK_I].movement = MOVE_NONE;
+		entities[LINK_I].speed_vect = (vector_t){0, 0};
+		break;
+	}
+}
 
-		if(*pnumber == 3 && *sync == 1) {
-			if(game.state == PLAYER1) {
-				if((packet[0] & MOUSE_XOV) == 0 && (packet[0] & MOUSE_YOV) == 0 && entities[LINK_I].state != KNOCKBACK_DMG) {
-					logic_mouse_handler(mode);
-				}
-			}
-		}
 
-		return 0;
-	} else {
+uint8_t logic_check_end() {
+	if(game.state == END) {
+		return TRUE;
+	} else return FALSE;
+}
 
-		//Reset pnumber if needed
-		if(*pnumber == 4) {
-			*pnumber = 0;
-		}
 
-		packet[*pnumber] = data;
+int8_t logic_mouse_input(uint32_t data) {
 
-		if((packet[*pnumber] & SYNC_BIT) && *sync == 0) {
-			*pnumber = 0;
-			*sync = 1;
-		}
+	mouse_ring_push(data & 0xFF);
 
-		(*pnumber)++;
+	return 0;
+}
 
-		if((packet[0] & SYNC_BIT) == 0) {
-			*sync = 0;
-		}
 
-		if(*pnumber == 4 && *sync == 1) {
-			if(game.state == PLAYER1) {
-				if((packet[0] & MOUSE_XOV) == 0 && (packet[0] & MOUSE_YOV) == 0 && entities[LINK_I].state != KNOCKBACK_DMG) {
-					logic_mouse_handler(mode);
-				}
-			}
-		}
+int8_t logic_mouse_decode(uint8_t mode) {
 
+	mouse_packet_t packet;
+	uint8_t packet_size = (mode == MOUSE_SCROLL_EX) ? 4 : 3;
+
+	if(mouse_decode(&packet, packet_size) == 0) {
 		return 0;
 	}
-}
 
+	if(game.state == PLAYER1 && entities[LINK_I].state != KNOCKBACK_DMG) {
+		logic_mouse_handler(&packet, mode);
+	}
 
-int8_t logic_mouse_handler(uint8_t mode) {
+	return 0;
+}
 
-	int16_t mouse_dx, mouse_dy;
 
-	if((packet[0] & MOUSE_XS) == MOUSE_XS) {
-		mouse_dx = ((~packet[1] + 1) & 0xFF) * -1;
-	} else {
-		mouse_dx = packet[1];
-	}
+int8_t logic_mouse_handler(mouse_packet_t* packet, uint8_t mode) {
 
-	if((packet[0] & MOUSE_YS) == MOUSE_YS) {
-		mouse_dy = ((~packet[2] + 1) & 0xFF) * -1;
-	} else {
-		mouse_dy = packet[2];
-	}
+	int16_t mouse_dx = packet->dx;
+	int16_t mouse_dy = packet->dy;
 
 	//Check left button
-	if((packet[0] & MOUSE_LB) == MOUSE_LB) {
+	if((packet->buttons & MOUSE_LB) == MOUSE_LB) {
 		if(entities[SWORD_I].state != ATTACKING && entities[SWORD_I].cooldown.attack == 0 && entities[LINK_I].state == NORMAL) {
 			entities[SWORD_I].hitpoints = 1;
 			entities[SWORD_I].cooldown.attack = SWORD_FRAMES;
 			entities[SWORD_I].state = ATTACKING;
 		}
-	} else if((packet[0] & MOUSE_LB) == 0 && entities[SWORD_I].state == ATTACKING) {
+	} else if((packet->buttons & MOUSE_LB) == 0 && entities[SWORD_I].state == ATTACKING) {
 			entities[SWORD_I].state = NORMAL;
 	}
 
@@ -1545,21 +2219,20 @@ int8_t logic_mouse_handler(uint8_t mode) {
 		entities[LINK_I].speed_vect = (vector_t){0, 0};
 
 		if(mode == MOUSE_SCROLL_EX) {
-			uint8_t scroll = packet[3] & MOUSE_SCROLL_PACKET;
 
-			if(scroll >= MOUSE_PLUS_MIN && scroll <= MOUSE_PLUS_MAX) {
+			if(packet->dz > 0) {
 				entities[LINK_I].movement = MOVE_DOWN;
 				entities[LINK_I].speed_vect = (vector_t){0, entities[LINK_I].speed};
 				return 0;
-			} else if(scroll >= MOUSE_MINUS_MAX && scroll <= MOUSE_MINUS_MIN) {
+			} else if(packet->dz < 0) {
 				entities[LINK_I].movement = MOVE_UP;
 				entities[LINK_I].speed_vect = (vector_t){0, -entities[LINK_I].speed};
 				return 0;
-			} else if((packet[3] & MOUSE_4B) == MOUSE_4B) {
+			} else if((packet->extra & MOUSE_4B) == MOUSE_4B) {
 				entities[LINK_I].movement = MOVE_RIGHT;
 				entities[LINK_I].speed_vect = (vector_t){entities[LINK_I].speed, 0};
 				return 0;
-			} else if((packet[3] & MOUSE_5B) == MOUSE_5B) {
+			} else if((packet->extra & MOUSE_5B) == MOUSE_5B) {
 				entities[LINK_I].movement = MOVE_LEFT;
 				entities[LINK_I].speed_vect = (vector_t){-entities[LINK_I].speed, 0};
 				return 0;
@@ -1657,8 +2330,6 @@ int8_t logic_serial_tick() {
 		serial_cooldown.number--;
 	}
 
-	logic_font_number(&serial_cooldown);
-
 	return 0;
 }
 
@@ -1669,14 +2340,9 @@ int8_t logic_display_serial() {
 
 	vg_png((point_t){0, 0}, serial_image.image_width, serial_image.image_height, serial_image.image);
 
-	size_t i;
 	point_t fontcoords = (point_t){205, 450};
-	for(i = 0; i < serial_cooldown.word_size; i++) {
-		if(serial_cooldown.word[i] != 0) {
-			vg_font(fontcoords, serial_cooldown.fontdata_width, serial_cooldown.tilesperline, serial_cooldown.fontdata, serial_cooldown.word[i] - FONT_START);
-			fontcoords.x += FONT_W + serial_cooldown.coords.x;
-		}
-	}
+	logic_font_render(&serial_cooldown);
+	vg_blit(fontcoords, &serial_cooldown.run, serial_cooldown.run_width, FONT_H);
 
 	vg_refresh();
 	return 0;
@@ -1691,10 +2357,9 @@ int8_t logic_lpng(png_t* png, const unsigned char* filename) {
 	strcpy(path, IMG_PATH);
 	strcat(path, filename);
 
-	int x, y, comp;
+	int x, y;
 
-	//stbi_image_free(png->image);
-	png->image = stbi_load(path, &x, &y, &comp, COMPONENTS);
+	png->image = logic_arena_load(path, &x, &y, MEM_IMAGES);
 
 	if(png->image == NULL) {
 		printf("LoLCOM: png: couldn't open png image\n");
@@ -1707,10 +2372,21 @@ int8_t logic_lpng(png_t* png, const unsigned char* filename) {
 	return 0;
 }
 
+int8_t logic_lsurface(surface_t* surface, const unsigned char* filename, unsigned long key_color) {
+
+	char path[64];
+
+	strcpy(path, IMG_PATH);
+	strcat(path, filename);
+
+	return logic_lsurface_path(surface, path, key_color);
+}
+
 int8_t logic_serial_free() {
 
 	stbi_image_free(serial_image.image);
-	stbi_image_free(serial_cooldown.fontdata);
+	logic_font_free(&serial_cooldown);
+	logic_resident_free();
 
 	vg_free();
 
@@ -1723,25 +2399,94 @@ int8_t logic_serial_free() {
 
 int8_t logic_lfont(font_t* font) {
 
-	int x, y, comp;
+	//Glyphs are converted to the framebuffer format only once, every font shares them
+	if(glyph_atlas.pixels == NULL) {
+		//HUD text is always drawn over black, the pink background becomes black
+		//Glyph colors are pinned so palette effects leave the HUD alone, like sprites
+		vg_palette_pin(TRUE);
+		int8_t ret = logic_lsurface_path(&glyph_atlas, FONT_PATH, BLACK);
+		vg_palette_pin(FALSE);
 
-	font->fontdata = stbi_load(FONT_PATH, &x, &y, &comp, COMPONENTS);
-
-	if(font->fontdata == NULL) {
-		printf("LoLCOM: font: couldn't open font data\n");
-		return -1;
+		if(ret != 0) {
+			printf("LoLCOM: font: couldn't open font data\n");
+			return -1;
+		}
 	}
 
-	font->fontdata_width = x;
+	font->glyphs = &glyph_atlas;
 	font->tilesperline = FONT_TILES_LINE;
 	font->coords = (point_t){0, 0};
+	font->run_valid = FALSE;
 
 	memset(font->word,0,sizeof(font->word));
 
+	if(vg_surface_alloc(&font->run, FONT_RUN_MAX * FONT_W, FONT_H) != 0) {
+		return -1;
+	}
+
 	return 0;
 }
 
 
+int8_t logic_font_render(font_t* font) {
+
+	if(font->run_valid == TRUE && font->run_number == font->number) {
+		return 0;
+	}
+
+	logic_font_number(font);
+
+	vg_surface_clear(&font->run);
+
+	point_t glyph_coords = (point_t){0, 0};
+
+	size_t i;
+	for(i = 0; i < font->word_size && i < FONT_RUN_MAX; i++) {
+		if(font->word[i] == 0) {
+			break;
+		}
+
+		if(vg_font(&font->run, glyph_coords, font->glyphs, font->tilesperline, font->word[i] - FONT_START) != 0) {
+			break;
+		}
+
+		glyph_coords.x += FONT_W + font->coords.x;
+	}
+
+	font->run_width = glyph_coords.x;
+	font->run_number = font->number;
+	font->run_valid = TRUE;
+
+	return 0;
+}
+
+
+void logic_font_free(font_t* font) {
+
+	vg_surface_free(&font->run);
+	font->run_valid = FALSE;
+}
+
+
+void logic_resident_free() {
+
+	vg_surface_free(&glyph_atlas);
+
+	size_t i;
+	for(i = 0; i < sprite_cached; i++) {
+		vg_sprite_free(&sprite_cache[i]);
+	}
+	sprite_cached = 0;
+
+	vg_surface_free(&menu[0]);
+	vg_surface_free(&menu[1]);
+	vg_surface_free(&menu[2]);
+	vg_surface_free(&triforce);
+
+	logic_arena_free();
+}
+
+
 int8_t logic_font_number(font_t* font) {
 
 	size_t i;
@@ -1800,10 +2545,52 @@ map_t map_get() {
 //entity_t functions
 //-----------------------------------------------------
 
+sprite_t* logic_lsprite(const char* path) {
+
+	size_t i;
+	for(i = 0; i < sprite_cached; i++) {
+		if(strcmp(sprite_paths[i], path) == 0) {
+			return &sprite_cache[i];
+		}
+	}
+
+	if(sprite_cached == SPRITE_CACHE_N) {
+		printf("LoLCOM: sprite: sprite cache is full\n");
+		return NULL;
+	}
+
+	int x, y;
+	unsigned char* sheet = logic_arena_load(path, &x, &y, MEM_IMAGES);
+
+	if(sheet == NULL) {
+		printf("LoLCOM: entity: couldn't open entity sprite sheet\n");
+		return NULL;
+	}
+
+	//Sprites keep their colors through palette effects in indexed modes
+	vg_palette_pin(TRUE);
+	int8_t ret = vg_sprite_compile(&sprite_cache[sprite_cached], sheet, x, y);
+	vg_palette_pin(FALSE);
+	stbi_image_free(sheet);
+
+	if(ret != 0) {
+		return NULL;
+	}
+
+	strncpy(sprite_paths[sprite_cached], path, sizeof(sprite_paths[0]) - 1);
+	sprite_paths[sprite_cached][sizeof(sprite_paths[0]) - 1] = 0;
+
+	return &sprite_cache[sprite_cached++];
+}
+
+
 int8_t logic_lentity(const unsigned char* entity_name, entity_t* entity, uint8_t isPC) {
 
 	char filename[64];
 
+	entity->spawn_id = 0;
+	ai_defaults(&entity->ai);
+
 	strcpy(filename, ENTITY_PATH);
 	strcat(filename, entity_name);
 	strcat(filename, ".csv");
@@ -1828,16 +2615,14 @@ int8_t logic_lentity(const unsigned char* entity_name, entity_t* entity, uint8_t
 
 
 		if(flags == SPRITESHEET) {
-			int x, y, comp;
+			entity->sprite = logic_lsprite(line);
 
-			entity->spritesheet = stbi_load(line, &x, &y, &comp, COMPONENTS);
-
-			if(entity->spritesheet == NULL) {
-				printf("LoLCOM: entity: couldn't open entity sprite sheet\n");
+			if(entity->sprite == NULL) {
+				mem_free(line);
+				fclose(entity_data);
 				return -1;
 			}
 
-			entity->spritesheet_width = x;
 			flags = 0;
 
 		} else if(flags == TILESPERLINE) {
@@ -1852,6 +2637,18 @@ int8_t logic_lentity(const unsigned char* entity_name, entity_t* entity, uint8_t
 		} else if(flags == SPEED) {
 			entity->speed = parse_ulong(line, 10);
 			flags = 0;
+		} else if(flags == BEHAVIOR) {
+			ai_compile(&entity->ai, line);
+			flags = 0;
+		} else if(flags == SIGHT) {
+			entity->ai.sight = parse_ulong(line, 10);
+			flags = 0;
+		} else if(flags == PERIOD) {
+			entity->ai.period = parse_ulong(line, 10);
+			flags = 0;
+		} else if(flags == DASH_SPEED) {
+			entity->ai.dash_speed = parse_ulong(line, 10);
+			flags = 0;
 		}
 
 		if(strncmp(line, "spritesheet", strlen("spritesheet")) == 0) {
@@ -1864,12 +2661,24 @@ int8_t logic_lentity(const unsigned char* entity_name, entity_t* entity, uint8_t
 			flags = HITPOINTS;
 		} else if(strncmp(line, "speed", strlen("speed")) == 0) {
 			flags = SPEED;
+		} else if(strncmp(line, "behavior", strlen("behavior")) == 0) {
+			flags = BEHAVIOR;
+		} else if(strncmp(line, "sight", strlen("sight")) == 0) {
+			flags = SIGHT;
+		} else if(strncmp(line, "period", strlen("period")) == 0) {
+			flags = PERIOD;
+		} else if(strncmp(line, "dash", strlen("dash")) == 0) {
+			flags = DASH_SPEED;
 		}
 
 	} while(nread != -1);
 
+	mem_free(line);
 	fclose(entity_data);
 
+	//Parameters may come after the behavior, the first state's timer is set again with them
+	ai_reset(&entity->ai);
+
 	if(isPC == TRUE) {
 		entity->currsprite = (uint8_t) MOVE_UP;
 		entity->movement = MOVE_NONE;
@@ -2,6 +2,8 @@
 #define LOGIC_H
 
 #include "LoLCOM.h"
+#include "mouse.h"
+#include "mem.h"
 
 //Initializes the game for Player 1 mode, called between transitions from menu to game
 //Returns 0 upon success, -1 otherwise
@@ -12,28 +14,74 @@ void logic_player1_free();
 
 //Initializes the main menu for Player 1 mode, called at the start of Player 1 mode
 //Game over and exiting the game transitions to this state
+//Menu images are loaded on the first call and stay loaded until logic_resident_free()
 //Returns 0 upon success, -1 otherwise
 int8_t logic_menu_init();
 
-//Frees memory used by the game on the main menu of Player 1 mode
-void logic_menu_free();
-
 //State machine, changes states according to latest event and current state
 void logic_change_state(game_event_t event);
 
-//Main gameloop, updates cooldowns, entities and display
+//Calibrates the TSC so logic_sim_task() can run the simulation at a fixed rate
+//Must be called before Timer 0 is reprogrammed
+//Returns 0 upon success, -1 otherwise (simulation stays locked to the timer tick)
+int8_t logic_timing_init();
+
+//Prints how many rendered frames were skipped to keep the simulation speed
+void logic_timing_print();
+
+//Allocates the memory arenas of every game state and selects the menu's, call before logic_menu_init()
+//Returns 0 upon success, -1 otherwise
+int8_t logic_arena_init();
+
+//Selects the arena of the state being entered, after dropping everything allocated in it and in the states after it
+//Player 2 mode has no arenas, images are allocated with malloc then
+void logic_arena_enter(state_t state);
+
+//Prints how much of each arena was used at most
+void logic_arena_print();
+
+//Frees the memory arenas, called by logic_resident_free()
+void logic_arena_free();
+
+//Reads a PNG in one block and decodes it to RGB in the current arena, the file and the decoder's scratch buffers are given back right away
+//param tag - subsystem the image is counted under
+//Returns the image, NULL upon failure
+unsigned char* logic_arena_load(const char* path, int* x, int* y, mem_tag_t tag);
+
+//Scheduler task, handles queued input events and applies the resulting state changes
+void logic_input_task(uint32_t arg);
+
+//Scheduler task, runs as many fixed simulation steps as the real time elapsed requires
+//param mouse_mode - mouse id returned by mouse_magic_sequence(), selects the packet size
+void logic_sim_task(uint32_t mouse_mode);
+
+//Scheduler task, renders a frame unless the simulation is still behind
+void logic_render_task(uint32_t arg);
+
+//Runs a single simulation step (1 / SIM_HZ seconds): input decoding, cooldowns, entities and map scrolling
+//param mouse_mode - mouse id returned by mouse_magic_sequence(), selects the packet size
 //Returns 0 upon success
-int8_t logic_gameloop();
+int8_t logic_simulate(uint8_t mouse_mode);
 
-//Main dispatcher of Player 1 mode, receives interrupts from driver_receive
+//Main dispatcher of Player 1 mode, receives the events logic_input_drain() pops
 //and sends them to the correct handlers according to the current game state
+//param mode - keyboard origin for KBD_INT
 //Returns 0 upon success
-int8_t logic_handler(uint32_t data, uint8_t* pnumber, uint8_t* sync, uint8_t mode, origin_t origin);
+int8_t logic_handler(uint32_t data, uint8_t mode, origin_t origin);
+
+//Handles the input events queued by the interrupt path since the last tick, in order
+//Stops after an event requesting a state change, the caller applies it before the next pass
+//Returns 0 upon success
+int8_t logic_input_drain();
 
 //Loads a map .csv file to struct map_t
 //Returns 0 upon success, -1 otherwise
 int8_t logic_lmap(const unsigned char* filename, map_t* map);
 
+//Returns the tileset at path, decoding and converting it only the first time it's used since entering PLAYER1
+//Returns NULL upon failure
+tileset_t* logic_ltileset(const char* path);
+
 //Given an entities coords determines the coords of the tile the entities' standing on
 //Used for collision detection with the map
 //param entity - coords of the entity to find current tile of
@@ -57,6 +105,13 @@ void logic_update_movement(entity_t* entity);
 
 int8_t logic_playercol();
 
+//Runs one step of an enemy's behavior state machine and sets its speed from the resulting motion
+//param entity - enemy to move, called every simulation step while it's in NORMAL state
+void logic_enemy_behave(entity_t* entity);
+
+//Sets an enemy's speed to follow the shared flow field toward Link's tile, one lookup per call
+//Enemies with no path to Link wander randomly once per cooldown.move
+//param entity - enemy to move, called by logic_enemy_behave() while the enemy is chasing
 void logic_enemy_move(entity_t* entity);
 
 int8_t logic_entitycol();
@@ -81,17 +136,37 @@ uint8_t logic_aabbcol(entity_t entity);
 
 int8_t logic_clear_enemies();
 
-int8_t logic_rtc_handler();
+//Handles an RTC interrupt, register C was read in the interrupt path
+//Periodic interrupts advance the timed event clock while playing and fire every event that became due
+//param regC - RTC register C read when the interrupt arrived
+//Returns 0 upon success, -1 otherwise
+int8_t logic_rtc_handler(uint32_t regC);
 
 int8_t logic_rtc_spawn(unsigned char* enemy_type);
 
 int8_t logic_kbd_input(uint32_t scancode, uint8_t origin);
 
+//Builds the key to action table from the keybinds and releases every key, called when Player 1 mode starts
+void logic_keybinds_init();
+
+//Applies a key press or release mapped to an action to the current game state
+//Movement actions only mark the movement to be resolved by logic_resolve_movement()
+void logic_action(action_t action, uint8_t pressed);
+
+//Sets Link's movement from the movement keys currently held, if they changed or knockback ended
+//Called once per simulation step
+void logic_resolve_movement();
+
 int8_t logic_game_over_fade(uint8_t stage);
 
-int8_t logic_mouse_input(uint32_t data, uint8_t* pnumber, uint8_t* sync, uint8_t mode);
+//Stores a mouse byte in the mouse ring buffer, called from the interrupt path
+int8_t logic_mouse_input(uint32_t data);
+
+//Decodes every mouse packet received since the last frame and updates Link's movement once
+//param mode - mouse id returned by mouse_magic_sequence(), selects the packet size
+int8_t logic_mouse_decode(uint8_t mode);
 
-int8_t logic_mouse_handler(uint8_t mode);
+int8_t logic_mouse_handler(mouse_packet_t* packet, uint8_t mode);
 
 int8_t logic_serial_handler(uint32_t serial_rcv);
 
@@ -105,6 +180,14 @@ int8_t logic_display_serial();
 
 int8_t logic_lpng(png_t* png, const unsigned char* filename);
 
+//Loads a png from IMG_PATH straight to a surface in the framebuffer format, must be called after vg_init_values()
+//param key_color - color TRANSPARENT pixels are stored as, TRANSPARENT keeps them for vg_blit_keyed()
+//Returns 0 upon success, -1 otherwise
+int8_t logic_lsurface(surface_t* surface, const unsigned char* filename, unsigned long key_color);
+
+//Same as logic_lsurface() with a full path, the PNG is converted to the surface without an RGB copy of the whole image
+int8_t logic_lsurface_path(surface_t* surface, const char* path, unsigned long key_color);
+
 //-----------------------------------------------------
 //font_t functions
 //-----------------------------------------------------
@@ -113,6 +196,16 @@ int8_t logic_lfont(font_t* font);
 
 int8_t logic_font_number(font_t* font);
 
+//Renders the font's word into its cached text run, only when number changed since the last render
+//Returns 0 upon success
+int8_t logic_font_render(font_t* font);
+
+//Frees the font's cached text run, the shared glyph atlas stays loaded
+void logic_font_free(font_t* font);
+
+//Frees data kept loaded for the whole process (glyph atlas, menu images, sprites), called once when exiting
+void logic_resident_free();
+
 //-----------------------------------------------------
 //map_t functions
 //-----------------------------------------------------
@@ -123,6 +216,10 @@ map_t map_get();
 //entity_t functions
 //-----------------------------------------------------
 
+//Returns the compiled sprite sheet at path, decoding and compiling it only the first time it's used
+//Returns NULL upon failure
+sprite_t* logic_lsprite(const char* path);
+
 int8_t logic_lentity(const unsigned char* entity_name, entity_t* entity, uint8_t isPC);
 
 #endif //LOGIC_H
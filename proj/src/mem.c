@@ -0,0 +1,168 @@
+#include <minix/syslib.h>
+#include <minix/drivers.h>
+#include <minix/types.h>
+
+#include <stdlib.h>
+
+#include "mem.h"
+
+//Stored in front of every mem_alloc() block, the union keeps the block aligned like malloc()
+typedef union {
+	struct {
+		size_t size;
+		mem_tag_t tag;
+	} info;
+	double align[2];
+} mem_header_t;
+
+static const char* tag_names[MEM_TAGS] = {"video", "images", "maps", "audio", "parsing"};
+
+static size_t live[MEM_TAGS];			//Bytes allocated and not given back yet
+static size_t transition_live[MEM_TAGS];	//live at the previous mem_transition()
+static size_t state_peak[MEM_TAGS];		//Highest live since the previous mem_transition()
+static size_t state_peak_total = 0;		//Highest sum of live since the previous mem_transition()
+static size_t run_peak_total = 0;		//Highest sum of live since the start
+static size_t live_total = 0;
+static uint32_t live_blocks = 0;		//mem_alloc() blocks not freed yet
+static mem_tag_t current_tag = MEM_TAG_DEFAULT;
+
+
+void mem_add(mem_tag_t tag, size_t bytes) {
+
+	live[tag] += bytes;
+	live_total += bytes;
+
+	if(live[tag] > state_peak[tag]) {
+		state_peak[tag] = live[tag];
+	}
+
+	if(live_total > state_peak_total) {
+		state_peak_total = live_total;
+	}
+
+	if(live_total > run_peak_total) {
+		run_peak_total = live_total;
+	}
+}
+
+
+void mem_sub(mem_tag_t tag, size_t bytes) {
+
+	if(bytes > live[tag]) {
+		printf("mem: mem_sub: %s gives back more than it has live\n", tag_names[tag]);
+		bytes = live[tag];
+	}
+
+	live[tag] -= bytes;
+	live_total -= bytes;
+}
+
+
+void* mem_alloc(mem_tag_t tag, size_t size) {
+
+	mem_header_t* header = (mem_header_t*) malloc(sizeof(mem_header_t) + size);
+
+	if(header == NULL) {
+		return NULL;
+	}
+
+	header->info.size = size;
+	header->info.tag = tag;
+
+	mem_add(tag, size);
+	live_blocks++;
+
+	return header + 1;
+}
+
+
+void* mem_realloc(mem_tag_t tag, void* ptr, size_t size) {
+
+	if(ptr == NULL) {
+		return mem_alloc(tag, size);
+	}
+
+	mem_header_t* header = (mem_header_t*) ptr - 1;
+	size_t old_size = header->info.size;
+
+	header = (mem_header_t*) realloc(header, sizeof(mem_header_t) + size);
+
+	if(header == NULL) {
+		return NULL;
+	}
+
+	header->info.size = size;
+
+	if(size > old_size) {
+		mem_add(header->info.tag, size - old_size);
+	} else mem_sub(header->info.tag, old_size - size);
+
+	return header + 1;
+}
+
+
+void mem_free(void* ptr) {
+
+	if(ptr == NULL) {
+		return;
+	}
+
+	mem_header_t* header = (mem_header_t*) ptr - 1;
+
+	mem_sub(header->info.tag, header->info.size);
+	live_blocks--;
+
+	free(header);
+}
+
+
+mem_tag_t mem_tag(mem_tag_t tag) {
+
+	mem_tag_t previous = current_tag;
+	current_tag = tag;
+
+	return previous;
+}
+
+
+mem_tag_t mem_current_tag() {
+	return current_tag;
+}
+
+
+size_t mem_live(mem_tag_t tag) {
+	return live[tag];
+}
+
+
+void mem_transition(const char* from, const char* to) {
+
+	printf("LoLCOM: memory: %s -> %s, %d bytes live, peak %d bytes in %s\n", from, to, live_total, state_peak_total, from);
+
+	size_t i;
+	for(i = 0; i < MEM_TAGS; i++) {
+		if(live[i] >= transition_live[i]) {
+			printf("LoLCOM: memory:   %s: %d bytes (+%d), peak %d\n", tag_names[i], live[i], live[i] - transition_live[i], state_peak[i]);
+		} else {
+			printf("LoLCOM: memory:   %s: %d bytes (-%d), peak %d\n", tag_names[i], live[i], transition_live[i] - live[i], state_peak[i]);
+		}
+
+		transition_live[i] = live[i];
+		state_peak[i] = live[i];
+	}
+
+	state_peak_total = live_total;
+}
+
+
+void mem_print() {
+
+	printf("LoLCOM: memory: peak %d bytes, %d bytes in %d blocks still live\n", run_peak_total, live_total, live_blocks);
+
+	size_t i;
+	for(i = 0; i < MEM_TAGS; i++) {
+		if(live[i] != 0) {
+			printf("LoLCOM: memory:   %s: %d bytes leaked\n", tag_names[i], live[i]);
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#ifndef MEM_H
+#define MEM_H
+
+//-----------------------------------------------------
+//Memory Accounting Types
+//-----------------------------------------------------
+
+//Subsystem an allocation belongs to
+typedef enum {MEM_VIDEO, MEM_IMAGES, MEM_MAPS, MEM_AUDIO, MEM_PARSING, MEM_TAGS} mem_tag_t;
+
+//-----------------------------------------------------
+//Memory Accounting Constants
+//-----------------------------------------------------
+
+#define MEM_TAG_DEFAULT		MEM_IMAGES		//Tag of arena allocations until mem_tag() selects another one
+
+//-----------------------------------------------------
+//Memory Accounting Function definitions
+//-----------------------------------------------------
+
+//malloc, realloc and free counting live bytes under tag, blocks must be freed with mem_free()
+//mem_realloc() keeps the tag the block was allocated with, tag is used when ptr is NULL
+void* mem_alloc(mem_tag_t tag, size_t size);
+void* mem_realloc(mem_tag_t tag, void* ptr, size_t size);
+void mem_free(void* ptr);
+
+//Counts bytes allocated or given back outside mem_alloc(), used by the memory arenas
+void mem_add(mem_tag_t tag, size_t bytes);
+void mem_sub(mem_tag_t tag, size_t bytes);
+
+//Selects the tag arena allocations are counted under
+//@return previously selected tag
+mem_tag_t mem_tag(mem_tag_t tag);
+
+mem_tag_t mem_current_tag();
+
+//Returns the bytes currently live under tag
+size_t mem_live(mem_tag_t tag);
+
+//Prints live bytes per tag and their change since the previous transition, and the peak reached in the state being left
+//Starts measuring the peak of the state being entered
+void mem_transition(const char* from, const char* to);
+
+//Prints the peak of the whole run and what is still live, anything live after every free is a leak
+void mem_print();
+
+#endif //MEM_H
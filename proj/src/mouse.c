@@ -6,6 +6,21 @@
 
 static int mouse_hook; //Mouse hook id
 
+//Raw bytes received by the interrupt path, decoded once per frame by mouse_decode()
+static uint8_t ring[MOUSE_RING_SIZE];
+static uint16_t ring_head = 0;	//Next position to write
+static uint16_t ring_tail = 0;	//Next position to read
+
+//Packet being assembled across calls to mouse_decode()
+static uint8_t packet[4];
+static uint8_t pnumber = 0;
+
+//Effective sample rate measurement
+static uint16_t rate_packets = 0;	//Packets decoded in the current window
+static uint16_t rate_frames = 0;	//Frames that received packets in the current window
+static uint16_t frame_packets = 0;	//Packets decoded since the last mouse_rate_tick()
+static uint16_t measured_rate = 0;	//Packets per second on the last window with movement
+
 //Tries to return mouse control to MINIX
 void mouse_reset(int data_report) {
 
@@ -262,3 +277,228 @@ int8_t mouse_magic_sequence() {
 
 	return id;
 }
+
+
+void mouse_ring_push(uint8_t byte) {
+
+	ring[ring_head & (MOUSE_RING_SIZE - 1)] = byte;
+	ring_head++;
+
+	//Ring is full, drop the oldest byte
+	if((uint16_t) (ring_head - ring_tail) > MOUSE_RING_SIZE) {
+		ring_tail++;
+	}
+}
+
+
+void mouse_ring_flush() {
+	ring_tail = ring_head;
+	pnumber = 0;
+}
+
+
+//Checks if an assembled packet can be trusted
+static uint8_t mouse_packet_valid(uint8_t packet_size) {
+
+	if((packet[0] & SYNC_BIT) == 0) {
+		return FALSE;
+	}
+
+	if(packet_size == 4 && (packet[3] & MOUSE_4TH_ZERO) != 0) {
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+
+uint8_t mouse_decode(mouse_packet_t* acc, uint8_t packet_size) {
+
+	*acc = (mouse_packet_t) {0, 0, 0, 0, 0, 0};
+
+	while(ring_tail != ring_head) {
+
+		uint8_t byte = ring[ring_tail & (MOUSE_RING_SIZE - 1)];
+		ring_tail++;
+
+		//1st byte of a packet always has the SYNC bit set, drop anything else
+		if(pnumber == 0 && (byte & SYNC_BIT) == 0) {
+			continue;
+		}
+
+		packet[pnumber] = byte;
+		pnumber++;
+
+		if(pnumber < packet_size) {
+			continue;
+		}
+
+		//Packet out of sync, shift it by one byte and look for the next SYNC bit
+		if(mouse_packet_valid(packet_size) == FALSE) {
+
+			uint8_t i, j;
+			for(i = 1; i < packet_size; i++) {
+				if(packet[i] & SYNC_BIT) {
+					break;
+				}
+			}
+
+			for(j = 0; i < packet_size; i++, j++) {
+				packet[j] = packet[i];
+			}
+
+			pnumber = j;
+			continue;
+		}
+
+		pnumber = 0;
+
+		//Overflowed packets carry no usable movement
+		if((packet[0] & MOUSE_XOV) || (packet[0] & MOUSE_YOV)) {
+			continue;
+		}
+
+		acc->dx += (packet[0] & MOUSE_XS) ? (int16_t) packet[1] - 256 : (int16_t) packet[1];
+		acc->dy += (packet[0] & MOUSE_YS) ? (int16_t) packet[2] - 256 : (int16_t) packet[2];
+		acc->buttons |= packet[0] & (MOUSE_LB | MOUSE_RB | MOUSE_MB);
+
+		if(packet_size == 4) {
+			int16_t dz = packet[3] & MOUSE_SCROLL_PACKET;
+			acc->dz += (dz & MOUSE_SCROLL_SIGN) ? dz - 16 : dz;
+			acc->extra |= packet[3] & (MOUSE_4B | MOUSE_5B);
+		}
+
+		acc->count++;
+	}
+
+	frame_packets += acc->count;
+
+	return acc->count;
+}
+
+
+int8_t mouse_set_sample_rate(uint8_t rate) {
+
+	switch(rate) {
+	case MOUSE_SAMPLE10:
+	case MOUSE_SAMPLE20:
+	case MOUSE_SAMPLE40:
+	case MOUSE_SAMPLE60:
+	case MOUSE_SAMPLE80:
+	case MOUSE_SAMPLE100:
+	case MOUSE_SAMPLE200:
+		break;
+	default:
+		printf("mouse: mouse_set_sample_rate: %d samples/s is not supported\n", rate);
+		return -1;
+	}
+
+	if(mouse_command(SAMPLE_RATE) != 0 || mouse_command(rate) != 0) {
+		printf("mouse: mouse_set_sample_rate: failed to set sample rate\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+
+int8_t mouse_set_resolution(uint8_t resolution) {
+
+	if(resolution > MOUSE_RES_8) {
+		printf("mouse: mouse_set_resolution: invalid resolution\n");
+		return -1;
+	}
+
+	if(mouse_command(SET_RESOLUTION) != 0 || mouse_command(resolution) != 0) {
+		printf("mouse: mouse_set_resolution: failed to set resolution\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+
+int8_t mouse_set_scaling(uint8_t scaling) {
+
+	if(scaling != SCALING_1_1 && scaling != SCALING_2_1) {
+		printf("mouse: mouse_set_scaling: invalid scaling\n");
+		return -1;
+	}
+
+	if(mouse_command(scaling) != 0) {
+		printf("mouse: mouse_set_scaling: failed to set scaling\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+
+int8_t mouse_configure(mouse_config_t config) {
+
+	if(mouse_set_sample_rate(config.sample_rate) != 0) {
+		return -1;
+	}
+
+	if(mouse_set_resolution(config.resolution) != 0) {
+		return -1;
+	}
+
+	if(mouse_set_scaling(config.scaling) != 0) {
+		return -1;
+	}
+
+	return 0;
+}
+
+
+int8_t mouse_get_config(mouse_config_t* config) {
+
+	int status, resolution, rate;
+
+	if(mouse_command(STATUS_REQUEST) != 0) {
+		return -1;
+	}
+
+	status = mouse_read();
+	resolution = mouse_read();
+	rate = mouse_read();
+
+	if(status == KBD_ERROR || resolution == KBD_ERROR || rate == KBD_ERROR) {
+		printf("mouse: mouse_get_config: failed to read status bytes\n");
+		return -1;
+	}
+
+	config->sample_rate = rate;
+	config->resolution = resolution;
+	config->scaling = (status & MOUSE_SCALING) ? SCALING_2_1 : SCALING_1_1;
+
+	return 0;
+}
+
+
+void mouse_rate_tick() {
+
+	//Mouse only reports while moving, frames without packets would lower the rate
+	if(frame_packets == 0) {
+		return;
+	}
+
+	rate_packets += frame_packets;
+	frame_packets = 0;
+	rate_frames++;
+
+	if(rate_frames < MOUSE_RATE_WINDOW) {
+		return;
+	}
+
+	measured_rate = rate_packets * 60 / MOUSE_RATE_WINDOW;
+
+	rate_packets = 0;
+	rate_frames = 0;
+}
+
+
+uint16_t mouse_measured_rate() {
+	return measured_rate;
+}
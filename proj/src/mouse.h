@@ -1,6 +1,40 @@
 #ifndef MOUSE_H
 #define MOUSE_H
 
+//-----------------------------------------------------
+//Mouse Types
+//-----------------------------------------------------
+
+//Mouse packets coalesced by mouse_decode()
+typedef struct {
+	int16_t dx;			//Accumulated X axis movement
+	int16_t dy;			//Accumulated Y axis movement
+	int16_t dz;			//Accumulated scroll wheel movement (4th packet only)
+	uint8_t buttons;	//Buttons held in any of the coalesced packets (1st packet bits)
+	uint8_t extra;		//4th/5th buttons held in any of the coalesced packets (4th packet bits)
+	uint8_t count;		//Number of valid packets coalesced
+} mouse_packet_t;
+
+//Mouse configuration set by mouse_configure() or read by mouse_get_config()
+typedef struct {
+	uint8_t sample_rate;	//Samples per second (10, 20, 40, 60, 80, 100 or 200)
+	uint8_t resolution;		//MOUSE_RES_1 to MOUSE_RES_8
+	uint8_t scaling;		//SCALING_1_1 or SCALING_2_1
+} mouse_config_t;
+
+//-----------------------------------------------------
+//Mouse Constants
+//-----------------------------------------------------
+
+#define MOUSE_RING_SIZE		64		//Raw byte ring buffer size, must be a power of 2
+#define MOUSE_SCROLL_SIGN	BIT(3)	//Sign bit of the 4 bit scroll wheel value
+#define MOUSE_4TH_ZERO		(BIT(6) | BIT(7))	//Bits always 0 on the 4th packet, used to validate it
+#define MOUSE_RATE_WINDOW	60		//Frames (60Hz) with packets used to measure the effective sample rate
+
+//-----------------------------------------------------
+//Mouse Function definitions
+//-----------------------------------------------------
+
 //Sleep 20ms*cycles for i8042 interfacing
 //Uses tickdelay from MINIX
 void delay(int cycles);
@@ -44,4 +78,51 @@ int mouse_config();
 
 int8_t mouse_magic_sequence();
 
+//Stores a raw byte read from the output buffer, called from the interrupt path
+//Oldest unread byte is overwritten if the ring is full, mouse_decode() resyncs afterwards
+//@param byte - byte read from the PS/2 controller
+void mouse_ring_push(uint8_t byte);
+
+//Discards every byte stored in the ring and any partially assembled packet
+void mouse_ring_flush();
+
+//Drains the ring buffer assembling packets, resyncing on the SYNC bit, and coalesces
+//every complete packet into one accumulated packet
+//@param acc - struct to fill with the accumulated movement and buttons
+//@param packet_size - 3 for standard packets, 4 when the 4th packet is enabled
+//@return number of valid packets coalesced
+uint8_t mouse_decode(mouse_packet_t* acc, uint8_t packet_size);
+
+//Sets the mouse sample rate, data reporting should be disabled
+//@param rate - samples per second (10, 20, 40, 60, 80, 100 or 200)
+//@return 0 upon success, -1 otherwise
+int8_t mouse_set_sample_rate(uint8_t rate);
+
+//Sets the mouse resolution, data reporting should be disabled
+//@param resolution - MOUSE_RES_1 to MOUSE_RES_8
+//@return 0 upon success, -1 otherwise
+int8_t mouse_set_resolution(uint8_t resolution);
+
+//Sets the mouse scaling, data reporting should be disabled
+//@param scaling - SCALING_1_1 or SCALING_2_1
+//@return 0 upon success, -1 otherwise
+int8_t mouse_set_scaling(uint8_t scaling);
+
+//Sets sample rate, resolution and scaling, data reporting should be disabled
+//@param config - configuration to apply
+//@return 0 upon success, -1 otherwise
+int8_t mouse_configure(mouse_config_t config);
+
+//Reads the configuration the mouse is actually using with a status request
+//@param config - struct to fill
+//@return 0 upon success, -1 otherwise
+int8_t mouse_get_config(mouse_config_t* config);
+
+//Counts frames for the effective sample rate measurement, call once per frame (60Hz)
+//Only frames that received packets are counted, the rate isn't lowered while the mouse stands still
+void mouse_rate_tick();
+
+//Returns the effective sample rate measured over the last MOUSE_RATE_WINDOW frames the mouse was moving
+uint16_t mouse_measured_rate();
+
 #endif //MOUSE_H
@@ -0,0 +1,176 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+#include "pixel.h"
+
+//-----------------------------------------------------
+//Scalar kernels, used on their own when SSSE3 isn't available and for the tail of every SIMD kernel
+//-----------------------------------------------------
+
+void pixel_rgb_to_bgr24_scalar(uint8_t* dst, const uint8_t* src, size_t npixels) {
+
+	size_t i;
+	for(i = 0; i < npixels; i++, src += 3, dst += 3) {
+		dst[0] = src[2];
+		dst[1] = src[1];
+		dst[2] = src[0];
+	}
+}
+
+
+void pixel_rgb_to_xrgb8888_scalar(uint32_t* dst, const uint8_t* src, size_t npixels) {
+
+	size_t i;
+	for(i = 0; i < npixels; i++, src += 3) {
+		dst[i] = ((uint32_t) src[0] << 16) | ((uint32_t) src[1] << 8) | src[2];
+	}
+}
+
+
+void pixel_rgb_to_rgb565_scalar(uint16_t* dst, const uint8_t* src, size_t npixels) {
+
+	size_t i;
+	for(i = 0; i < npixels; i++, src += 3) {
+		dst[i] = ((src[0] & 0xF8) << 8) | ((src[1] & 0xFC) << 3) | (src[2] >> 3);
+	}
+}
+
+
+void pixel_key_mask_scalar(uint8_t* mask, const uint8_t* src, size_t npixels, uint32_t key) {
+
+	uint8_t r = (key >> 16) & 0xFF;
+	uint8_t g = (key >> 8) & 0xFF;
+	uint8_t b = key & 0xFF;
+
+	size_t i;
+	for(i = 0; i < npixels; i++, src += 3) {
+		mask[i] = (src[0] == r && src[1] == g && src[2] == b) ? 0xFF : 0x00;
+	}
+}
+
+#ifdef __SSSE3__
+
+//-----------------------------------------------------
+//SSSE3 kernels
+//Unaligned 16 byte loads read up to 4 bytes past the pixels they convert,
+//so the vector loops stop early enough to never read past src + npixels * 3
+//-----------------------------------------------------
+
+//4 RGB24 pixels (12 bytes) to 4 little endian 0x00RRGGBB lanes
+static inline __m128i pixel_load_xrgb(const uint8_t* src) {
+
+	const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128);
+
+	return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) src), shuffle);
+}
+
+
+void pixel_rgb_to_bgr24(uint8_t* dst, const uint8_t* src, size_t npixels) {
+
+	const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+
+	//5 pixels per iteration, the 16th byte stored belongs to the next pixel and gets rewritten
+	size_t i = 0;
+	for(; i + 6 <= npixels; i += 5) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (src + i * 3));
+		_mm_storeu_si128((__m128i*) (dst + i * 3), _mm_shuffle_epi8(v, shuffle));
+	}
+
+	pixel_rgb_to_bgr24_scalar(dst + i * 3, src + i * 3, npixels - i);
+}
+
+
+void pixel_rgb_to_xrgb8888(uint32_t* dst, const uint8_t* src, size_t npixels) {
+
+	size_t i = 0;
+	for(; i + 6 <= npixels; i += 4) {
+		_mm_storeu_si128((__m128i*) (dst + i), pixel_load_xrgb(src + i * 3));
+	}
+
+	pixel_rgb_to_xrgb8888_scalar(dst + i, src + i * 3, npixels - i);
+}
+
+
+void pixel_rgb_to_rgb565(uint16_t* dst, const uint8_t* src, size_t npixels) {
+
+	//8 pixels from two overlapping loads, a covers pixels 0-4, b (8 bytes later) covers pixels 5-7
+	//Every component is moved to the high byte of a 16-bit lane, then shifted into its RGB565 field
+	const __m128i r_a = _mm_setr_epi8(-128, 0, -128, 3, -128, 6, -128, 9, -128, 12, -128, -128, -128, -128, -128, -128);
+	const __m128i r_b = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 7, -128, 10, -128, 13);
+	const __m128i g_a = _mm_setr_epi8(-128, 1, -128, 4, -128, 7, -128, 10, -128, 13, -128, -128, -128, -128, -128, -128);
+	const __m128i g_b = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 8, -128, 11, -128, 14);
+	const __m128i b_a = _mm_setr_epi8(-128, 2, -128, 5, -128, 8, -128, 11, -128, 14, -128, -128, -128, -128, -128, -128);
+	const __m128i b_b = _mm_setr_epi8(-128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, 9, -128, 12, -128, 15);
+
+	size_t i = 0;
+	for(; i + 8 <= npixels; i += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i*) (src + i * 3));
+		__m128i b = _mm_loadu_si128((const __m128i*) (src + i * 3 + 8));
+
+		__m128i r = _mm_or_si128(_mm_shuffle_epi8(a, r_a), _mm_shuffle_epi8(b, r_b));
+		__m128i g = _mm_or_si128(_mm_shuffle_epi8(a, g_a), _mm_shuffle_epi8(b, g_b));
+		__m128i bl = _mm_or_si128(_mm_shuffle_epi8(a, b_a), _mm_shuffle_epi8(b, b_b));
+
+		r = _mm_and_si128(r, _mm_set1_epi16((short) 0xF800));
+		g = _mm_and_si128(_mm_srli_epi16(g, 5), _mm_set1_epi16(0x07E0));
+		bl = _mm_srli_epi16(bl, 11);
+
+		_mm_storeu_si128((__m128i*) (dst + i), _mm_or_si128(_mm_or_si128(r, g), bl));
+	}
+
+	pixel_rgb_to_rgb565_scalar(dst + i, src + i * 3, npixels - i);
+}
+
+
+void pixel_key_mask(uint8_t* mask, const uint8_t* src, size_t npixels, uint32_t key) {
+
+	const __m128i vkey = _mm_set1_epi32(key & 0x00FFFFFF);
+	const __m128i lowbytes = _mm_setr_epi8(0, 4, 8, 12, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128, -128);
+
+	size_t i = 0;
+	for(; i + 6 <= npixels; i += 4) {
+		__m128i eq = _mm_cmpeq_epi32(pixel_load_xrgb(src + i * 3), vkey);
+		int32_t bytes = _mm_cvtsi128_si32(_mm_shuffle_epi8(eq, lowbytes));
+		memcpy(mask + i, &bytes, 4);
+	}
+
+	pixel_key_mask_scalar(mask + i, src + i * 3, npixels - i, key);
+}
+
+
+const char* pixel_kernel_name() {
+	return "ssse3";
+}
+
+#else
+
+void pixel_rgb_to_bgr24(uint8_t* dst, const uint8_t* src, size_t npixels) {
+	pixel_rgb_to_bgr24_scalar(dst, src, npixels);
+}
+
+
+void pixel_rgb_to_xrgb8888(uint32_t* dst, const uint8_t* src, size_t npixels) {
+	pixel_rgb_to_xrgb8888_scalar(dst, src, npixels);
+}
+
+
+void pixel_rgb_to_rgb565(uint16_t* dst, const uint8_t* src, size_t npixels) {
+	pixel_rgb_to_rgb565_scalar(dst, src, npixels);
+}
+
+
+void pixel_key_mask(uint8_t* mask, const uint8_t* src, size_t npixels, uint32_t key) {
+	pixel_key_mask_scalar(mask, src, npixels, key);
+}
+
+
+const char* pixel_kernel_name() {
+	return "scalar";
+}
+
+#endif //__SSSE3__
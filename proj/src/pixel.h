@@ -0,0 +1,30 @@
+#ifndef PIXEL_H
+#define PIXEL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+//Pixel format conversion kernels, RGB24 as decoded by stb_image to framebuffer formats
+//Plain C with no MINIX dependencies so proj/tools can benchmark them on Linux
+//The pixel_* functions use SSSE3 when the compiler targets it and fall back to the *_scalar versions otherwise
+
+//RGB24 to BGR24 (VBE 24bpp, e.g. 0x112)
+void pixel_rgb_to_bgr24(uint8_t* dst, const uint8_t* src, size_t npixels);
+void pixel_rgb_to_bgr24_scalar(uint8_t* dst, const uint8_t* src, size_t npixels);
+
+//RGB24 to XRGB8888 (VBE 32bpp), X is 0
+void pixel_rgb_to_xrgb8888(uint32_t* dst, const uint8_t* src, size_t npixels);
+void pixel_rgb_to_xrgb8888_scalar(uint32_t* dst, const uint8_t* src, size_t npixels);
+
+//RGB24 to RGB565 (VBE 16bpp, e.g. 0x111, 0x114, 0x117)
+void pixel_rgb_to_rgb565(uint16_t* dst, const uint8_t* src, size_t npixels);
+void pixel_rgb_to_rgb565_scalar(uint16_t* dst, const uint8_t* src, size_t npixels);
+
+//Sets mask[i] to 0xFF where pixel i of src is the RGB color key (0xRRGGBB), 0 otherwise
+void pixel_key_mask(uint8_t* mask, const uint8_t* src, size_t npixels, uint32_t key);
+void pixel_key_mask_scalar(uint8_t* mask, const uint8_t* src, size_t npixels, uint32_t key);
+
+//Returns the name of the kernel set pixel_* functions use, "ssse3" or "scalar"
+const char* pixel_kernel_name();
+
+#endif //PIXEL_H
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <string.h>
+
+#define STBI_ONLY_PNG
+#include "stb_image.h"
+
+#include "pngload.h"
+
+#define PNG_RGB		3	//Components of the rows png_row() returns
+
+
+int8_t png_read(png_file_t* file, const char* path, void* (*alloc)(size_t), void (*release)(void*)) {
+
+	file->data = NULL;
+	file->size = 0;
+	file->release = release;
+
+	FILE* fp = fopen(path, "rb");
+
+	if(fp == NULL) {
+		printf("png: png_read: couldn't open %s\n", path);
+		return -1;
+	}
+
+	long size = -1;
+
+	if(fseek(fp, 0, SEEK_END) == 0) {
+		size = ftell(fp);
+		rewind(fp);
+	}
+
+	if(size <= 0) {
+		printf("png: png_read: couldn't get the size of %s\n", path);
+		fclose(fp);
+		return -1;
+	}
+
+	file->data = (uint8_t*) alloc(size);
+
+	if(file->data == NULL) {
+		printf("png: png_read: couldn't allocate %ld bytes for %s\n", size, path);
+		fclose(fp);
+		return -1;
+	}
+
+	if(fread(file->data, 1, size, fp) != (size_t) size) {
+		printf("png: png_read: couldn't read %s\n", path);
+		png_file_free(file);
+		fclose(fp);
+		return -1;
+	}
+
+	file->size = size;
+	fclose(fp);
+
+	return 0;
+}
+
+
+void png_file_free(png_file_t* file) {
+
+	if(file->data != NULL) {
+		file->release(file->data);
+	}
+
+	file->data = NULL;
+	file->size = 0;
+}
+
+
+int8_t png_decode(png_image_t* image, const png_file_t* file, uint8_t comps) {
+
+	int x, y, comp;
+
+	image->pixels = stbi_load_from_memory(file->data, file->size, &x, &y, &comp, comps);
+
+	if(image->pixels == NULL) {
+		printf("png: png_decode: %s\n", stbi_failure_reason());
+		return -1;
+	}
+
+	image->width = x;
+	image->height = y;
+	image->comps = comps != 0 ? comps : comp;
+
+	return 0;
+}
+
+
+const uint8_t* png_row(const png_image_t* image, uint16_t y, uint8_t* scratch) {
+
+	const uint8_t* src = image->pixels + (size_t) y * image->width * image->comps;
+	uint16_t width = image->width;
+
+	if(image->comps == PNG_RGB) {
+		return src;
+	}
+
+	uint8_t* dst = scratch;
+	uint16_t i;
+
+	switch(image->comps) {
+	case 4:
+		for(i = 0; i < width; i++, src += 4, dst += PNG_RGB) {
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+		}
+		break;
+	default:
+		//Gray, with or without alpha, alpha is dropped like stb_image does when asked for RGB
+		for(i = 0; i < width; i++, src += image->comps, dst += PNG_RGB) {
+			dst[0] = dst[1] = dst[2] = src[0];
+		}
+		break;
+	}
+
+	return scratch;
+}
+
+
+void png_image_free(png_image_t* image) {
+
+	stbi_image_free(image->pixels);
+	image->pixels = NULL;
+}
@@ -0,0 +1,44 @@
+#ifndef PNGLOAD_H
+#define PNGLOAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+//PNG loading front-end over stb_image: the file is read in one block and decoded from memory
+//in the PNG's own channel layout, rows are handed out as RGB24 so the pixel_* kernels convert
+//them straight to the framebuffer format, skipping stb_image's whole image RGB conversion
+//Plain C with no MINIX dependencies so proj/tools can benchmark it on Linux
+
+//PNG file contents, read with png_read()
+typedef struct {
+	uint8_t* data;
+	size_t size;
+	void (*release)(void*);	//Frees data, given to png_read() with the allocator
+} png_file_t;
+
+//Decoded image in the PNG's own channel layout
+typedef struct {
+	uint8_t* pixels;
+	uint16_t width;
+	uint16_t height;
+	uint8_t comps;		//1 gray, 2 gray + alpha, 3 RGB, 4 RGBA
+} png_image_t;
+
+//Reads the whole file with a single fread() into a buffer from alloc, png_file_free() gives it to release
+//Returns 0 upon success, -1 otherwise (nothing stays allocated)
+int8_t png_read(png_file_t* file, const char* path, void* (*alloc)(size_t), void (*release)(void*));
+
+void png_file_free(png_file_t* file);
+
+//Decodes a file read by png_read(), comps 0 keeps the PNG's own layout, 3 converts the whole image to RGB24
+//Pixels come from the stb_image allocator, free them with png_image_free()
+//Returns 0 upon success, -1 otherwise
+int8_t png_decode(png_image_t* image, const png_file_t* file, uint8_t comps);
+
+//Returns row y as RGB24 pixels, the caller checks the bounds
+//RGB images return a pointer into the image, other layouts are expanded into scratch (width * 3 bytes)
+const uint8_t* png_row(const png_image_t* image, uint16_t y, uint8_t* scratch);
+
+void png_image_free(png_image_t* image);
+
+#endif //PNGLOAD_H
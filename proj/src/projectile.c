@@ -0,0 +1,165 @@
+#include <minix/syslib.h>
+#include <minix/drivers.h>
+#include <minix/types.h>
+
+#include "LoLCOM.h"
+#include "projectile.h"
+#include "render.h"
+
+//Projectile pool, one array per field so proj_update() only touches what it needs
+static int16_t proj_x[PROJ_MAX];
+static int16_t proj_y[PROJ_MAX];
+static int8_t proj_vx[PROJ_MAX];
+static int8_t proj_vy[PROJ_MAX];
+static uint16_t proj_life[PROJ_MAX];	//Steps left, 0 if the slot is free
+static uint8_t proj_kind[PROJ_MAX];
+static uint8_t proj_dir[PROJ_MAX];
+static uint8_t proj_hostile[PROJ_MAX];
+static int16_t proj_next[PROJ_MAX];		//Next free slot, PROJ_NONE ends the free list
+
+static int16_t free_head = PROJ_NONE;
+static int16_t proj_high = 0;			//Slots past this one were never used since proj_clear()
+static sprite_t* kind_sprite[PROJ_KINDS];
+
+
+void proj_clear() {
+
+	int16_t i;
+	for(i = 0; i < PROJ_MAX; i++) {
+		proj_life[i] = 0;
+		proj_next[i] = i + 1 < PROJ_MAX ? i + 1 : PROJ_NONE;
+	}
+
+	free_head = 0;
+	proj_high = 0;
+}
+
+
+void proj_set_sprite(proj_kind_t kind, sprite_t* sprite) {
+	kind_sprite[kind] = sprite;
+}
+
+
+int16_t proj_spawn(proj_kind_t kind, point_t coords, event_t direction, uint8_t speed, uint16_t life, uint8_t hostile) {
+
+	if(free_head == PROJ_NONE || life == 0) {
+		return PROJ_NONE;
+	}
+
+	int16_t i = free_head;
+	free_head = proj_next[i];
+
+	if(i >= proj_high) {
+		proj_high = i + 1;
+	}
+
+	proj_x[i] = coords.x;
+	proj_y[i] = coords.y;
+	proj_vx[i] = direction == MOVE_LEFT ? -speed : direction == MOVE_RIGHT ? speed : 0;
+	proj_vy[i] = direction == MOVE_UP ? -speed : direction == MOVE_DOWN ? speed : 0;
+	proj_life[i] = life;
+	proj_kind[i] = kind;
+	proj_dir[i] = direction;
+	proj_hostile[i] = hostile;
+
+	return i;
+}
+
+
+void proj_kill(int16_t i) {
+
+	if(i < 0 || i >= PROJ_MAX || proj_life[i] == 0) {
+		return;
+	}
+
+	proj_life[i] = 0;
+	proj_next[i] = free_head;
+	free_head = i;
+}
+
+
+void proj_update(const uint8_t* collision) {
+
+	int16_t i;
+	for(i = 0; i < proj_high; i++) {
+
+		if(proj_life[i] == 0) {
+			continue;
+		}
+
+		proj_x[i] += proj_vx[i];
+		proj_y[i] += proj_vy[i];
+		proj_life[i]--;
+
+		//The tile under the projectile's center decides if it hit a wall
+		int16_t cx = proj_x[i] + TILESIZE / 2;
+		int16_t cy = proj_y[i] + TILESIZE / 2;
+
+		if(cx < 0 || cx >= MWIDTH * TILESIZE || cy < 0 || cy >= MHEIGHT * TILESIZE ||
+				collision[cx / TILESIZE + (cy / TILESIZE) * MWIDTH] == 0) {
+			proj_life[i] = 0;
+		}
+
+		if(proj_life[i] == 0) {
+			proj_next[i] = free_head;
+			free_head = i;
+		}
+	}
+}
+
+
+int16_t proj_hit(point_t coords, uint8_t hostile) {
+
+	int16_t i;
+	for(i = 0; i < proj_high; i++) {
+
+		if(proj_life[i] == 0 || proj_hostile[i] != hostile) {
+			continue;
+		}
+
+		int16_t left = proj_x[i] + (TILESIZE - PROJ_BOX) / 2;
+		int16_t top = proj_y[i] + (TILESIZE - PROJ_BOX) / 2;
+
+		if(left < coords.x + TILESIZE - 1 && left + PROJ_BOX - 1 > coords.x &&
+				top < coords.y + TILESIZE - 1 && top + PROJ_BOX - 1 > coords.y) {
+			return i;
+		}
+	}
+
+	return PROJ_NONE;
+}
+
+
+event_t proj_direction(int16_t i) {
+	return (event_t) proj_dir[i];
+}
+
+
+uint8_t proj_alive(proj_kind_t kind, uint8_t hostile) {
+
+	int16_t i;
+	for(i = 0; i < proj_high; i++) {
+		if(proj_life[i] != 0 && proj_kind[i] == kind && proj_hostile[i] == hostile) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+
+void proj_queue(point_t origin) {
+
+	int16_t i;
+	for(i = 0; i < proj_high; i++) {
+
+		sprite_t* sprite = kind_sprite[proj_kind[i]];
+
+		if(proj_life[i] == 0 || sprite == NULL) {
+			continue;
+		}
+
+		uint8_t tile = sprite->ntiles > 1 ? proj_dir[i] : 0;
+		render_sprite(LAYER_WEAPON, sprite, tile, (point_t){origin.x + proj_x[i], origin.y + proj_y[i]});
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef PROJECTILE_H
+#define PROJECTILE_H
+
+#include "LoLCOM.h"
+
+//-----------------------------------------------------
+//Projectile Pool Types
+//-----------------------------------------------------
+
+typedef enum {PROJ_ROCK, PROJ_BEAM, PROJ_KINDS} proj_kind_t;
+
+//-----------------------------------------------------
+//Projectile Pool Constants
+//-----------------------------------------------------
+
+#define PROJ_MAX			64		//Projectiles alive at the same time
+#define PROJ_NONE			-1
+#define PROJ_BOX			12		//Side of the hitbox, centered in the projectile's tile
+
+//-----------------------------------------------------
+//Projectile Pool Function definitions
+//-----------------------------------------------------
+
+//Removes every projectile, called when a game starts or the map changes
+void proj_clear();
+
+//Sets the sprite sheet a kind is drawn with, tile "direction" of it is used unless the sheet has a single tile
+void proj_set_sprite(proj_kind_t kind, sprite_t* sprite);
+
+//Takes a projectile from the free list, no memory is allocated
+//@param coords - top left corner of the projectile's tile, relative to the play area
+//@param direction - MOVE_* the projectile flies toward
+//@param hostile - TRUE if it hurts Link, FALSE if it hurts enemies
+//@param life - simulation steps until it disappears on its own
+//@return projectile index upon success, PROJ_NONE if the pool is full
+int16_t proj_spawn(proj_kind_t kind, point_t coords, event_t direction, uint8_t speed, uint16_t life, uint8_t hostile);
+
+//Frees a projectile, it goes back to the free list
+void proj_kill(int16_t i);
+
+//Moves every projectile one simulation step, removing the ones that hit a full block, leave the play area or expire
+//@param collision - MWIDTH x MHEIGHT collision grid of the current map
+void proj_update(const uint8_t* collision);
+
+//Finds a projectile whose hitbox overlaps a TILESIZE square
+//@param coords - top left corner of the square
+//@param hostile - TRUE looks for projectiles that hurt Link, FALSE for the ones that hurt enemies
+//@return projectile index, PROJ_NONE if there's none
+int16_t proj_hit(point_t coords, uint8_t hostile);
+
+//Returns the MOVE_* direction projectile i flies toward
+event_t proj_direction(int16_t i);
+
+//Returns TRUE if a projectile of this kind and side is alive
+uint8_t proj_alive(proj_kind_t kind, uint8_t hostile);
+
+//Queues every projectile on LAYER_WEAPON
+//@param origin - where the top left corner of the play area is drawn
+void proj_queue(point_t origin);
+
+#endif //PROJECTILE_H
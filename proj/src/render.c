@@ -0,0 +1,130 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "LoLCOM.h"
+#include "render.h"
+#include "video_gr.h"
+
+//Variables whose scope is render.c
+
+static render_cmd_t queue[RENDER_QUEUE_SIZE];
+static uint16_t queued = 0;
+
+
+void render_begin() {
+	queued = 0;
+}
+
+
+//Reserves the next command, NULL if the queue is full
+static render_cmd_t* render_push(layer_t layer, render_kind_t kind, const void* sheet, uint8_t tile, point_t dest) {
+
+	if(queued == RENDER_QUEUE_SIZE) {
+		return NULL;
+	}
+
+	render_cmd_t* cmd = &queue[queued];
+
+	cmd->layer = layer;
+	cmd->kind = kind;
+	cmd->sheet = sheet;
+	cmd->tile = tile;
+	cmd->dest = dest;
+	cmd->seq = queued++;
+
+	return cmd;
+}
+
+
+int8_t render_tile(layer_t layer, surface_t* tiles, uint8_t tilesperline, uint8_t tile, point_t dest) {
+
+	render_cmd_t* cmd = render_push(layer, CMD_TILE, tiles, tile, dest);
+
+	if(cmd == NULL) {
+		return -1;
+	}
+
+	cmd->tilesperline = tilesperline;
+
+	return 0;
+}
+
+
+int8_t render_sprite(layer_t layer, sprite_t* sprite, uint8_t tile, point_t dest) {
+
+	if(sprite == NULL) {
+		return -1;
+	}
+
+	return render_push(layer, CMD_SPRITE, sprite, tile, dest) == NULL ? -1 : 0;
+}
+
+
+int8_t render_surface(layer_t layer, surface_t* surface, uint16_t width, uint16_t height, point_t dest) {
+
+	render_cmd_t* cmd = render_push(layer, CMD_SURFACE, surface, 0, dest);
+
+	if(cmd == NULL) {
+		return -1;
+	}
+
+	cmd->width = width;
+	cmd->height = height;
+
+	return 0;
+}
+
+
+static int render_compare(const void* a, const void* b) {
+
+	const render_cmd_t* x = (const render_cmd_t*) a;
+	const render_cmd_t* y = (const render_cmd_t*) b;
+
+	if(x->layer != y->layer) {
+		return x->layer - y->layer;
+	}
+
+	if((RENDER_YSORT & BIT(x->layer)) && x->dest.y != y->dest.y) {
+		return x->dest.y - y->dest.y;
+	}
+
+	//Same sheet back to back keeps its pixels in cache
+	if(x->sheet != y->sheet) {
+		return x->sheet < y->sheet ? -1 : 1;
+	}
+
+	if(x->tile != y->tile) {
+		return x->tile - y->tile;
+	}
+
+	return x->seq - y->seq;
+}
+
+
+uint16_t render_flush() {
+
+	qsort(queue, queued, sizeof(render_cmd_t), render_compare);
+
+	uint16_t i;
+	for(i = 0; i < queued; i++) {
+
+		render_cmd_t* cmd = &queue[i];
+
+		switch(cmd->kind) {
+		case CMD_TILE:
+			vg_tile(cmd->dest, (surface_t*) cmd->sheet, cmd->tilesperline, cmd->tile);
+			break;
+		case CMD_SPRITE:
+			vg_sprite(cmd->dest, (sprite_t*) cmd->sheet, cmd->tile);
+			break;
+		case CMD_SURFACE:
+			vg_blit(cmd->dest, (surface_t*) cmd->sheet, cmd->width, cmd->height);
+			break;
+		}
+	}
+
+	uint16_t drawn = queued;
+	queued = 0;
+
+	return drawn;
+}
@@ -0,0 +1,57 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "LoLCOM.h"
+
+//-----------------------------------------------------
+//Render Queue Types
+//-----------------------------------------------------
+
+//Layers are drawn in this order
+typedef enum {LAYER_MAP, LAYER_ENTITY, LAYER_WEAPON, LAYER_HUD, LAYER_N} layer_t;
+
+typedef enum {CMD_TILE, CMD_SPRITE, CMD_SURFACE} render_kind_t;
+
+typedef struct {
+	uint8_t layer;				//layer_t
+	uint8_t kind;				//render_kind_t, selects which of the sources below is used
+	uint8_t tile;				//Tile of the tileset or sprite sheet
+	uint8_t tilesperline;		//CMD_TILE only
+	uint16_t width;				//CMD_SURFACE only, visible part of the surface
+	uint16_t height;
+	uint16_t seq;				//Submission order, keeps the sort stable
+	const void* sheet;			//Converted tileset, sprite_t* or surface_t*
+	point_t dest;				//Where the top left pixel goes on the draw target
+} render_cmd_t;
+
+//-----------------------------------------------------
+//Render Queue Constants
+//-----------------------------------------------------
+
+#define RENDER_QUEUE_SIZE	320			//Draw commands per frame, a full map is MAPSIZE of them plus up to PROJ_MAX projectiles
+#define RENDER_YSORT		BIT(LAYER_ENTITY)	//Layers drawn by y (lowest first) so overlaps look right
+
+//-----------------------------------------------------
+//Render Queue Function definitions
+//-----------------------------------------------------
+
+//Empties the queue, call at the start of every frame
+void render_begin();
+
+//Queues a TILESIZE tile of a tileset converted to the framebuffer format, drawn opaque
+//Returns 0 upon success, -1 if the queue is full
+int8_t render_tile(layer_t layer, surface_t* tiles, uint8_t tilesperline, uint8_t tile, point_t dest);
+
+//Queues a tile of a compiled sprite sheet
+//Returns 0 upon success, -1 if the queue is full
+int8_t render_sprite(layer_t layer, sprite_t* sprite, uint8_t tile, point_t dest);
+
+//Queues the top left width x height pixels of a surface, drawn opaque
+//Returns 0 upon success, -1 if the queue is full
+int8_t render_surface(layer_t layer, surface_t* surface, uint16_t width, uint16_t height, point_t dest);
+
+//Sorts the queue by layer, y (RENDER_YSORT layers only) and sheet, then draws every command to the back buffer
+//Returns number of commands drawn
+uint16_t render_flush();
+
+#endif //RENDER_H
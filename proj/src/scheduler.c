@@ -0,0 +1,113 @@
+#include <minix/syslib.h>
+#include <minix/drivers.h>
+#include <minix/types.h>
+
+#include "scheduler.h"
+#include "speaker.h"
+
+static sched_task_t tasks[SCHED_MAX_TASKS];
+static uint8_t ntasks = 0;
+static int8_t wheel[SCHED_WHEEL_SIZE];	//First task of each slot, -1 if empty
+static uint32_t current_tick = 0;
+
+
+//Inserts task in the slot of its deadline, keeps the slot ordered by task id
+static void sched_insert(int8_t id) {
+
+	int8_t* slot = &wheel[tasks[id].deadline & (SCHED_WHEEL_SIZE - 1)];
+
+	while(*slot != -1 && *slot < id) {
+		slot = &tasks[*slot].next;
+	}
+
+	tasks[id].next = *slot;
+	*slot = id;
+}
+
+
+int8_t sched_init() {
+
+	size_t i;
+	for(i = 0; i < SCHED_WHEEL_SIZE; i++) {
+		wheel[i] = -1;
+	}
+
+	ntasks = 0;
+	current_tick = 0;
+
+	if(timer_set_square(0, SCHED_HZ) != 0) {
+		printf("scheduler: sched_init: couldn't reprogram Timer 0\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+
+int8_t sched_exit() {
+
+	if(timer_set_square(0, SCHED_DEFAULT_HZ) != 0) {
+		printf("scheduler: sched_exit: couldn't restore Timer 0\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+
+int8_t sched_register(sched_callback_t callback, uint16_t rate, uint32_t arg) {
+
+	if(ntasks >= SCHED_MAX_TASKS || rate == 0 || rate > SCHED_HZ) {
+		printf("scheduler: sched_register: invalid rate or too many tasks\n");
+		return -1;
+	}
+
+	int8_t id = ntasks;
+	ntasks++;
+
+	tasks[id].callback = callback;
+	tasks[id].arg = arg;
+	tasks[id].rate = rate;
+	tasks[id].calls = 0;
+	tasks[id].start = current_tick;
+	tasks[id].deadline = current_tick + SCHED_HZ / rate;
+
+	sched_insert(id);
+
+	return id;
+}
+
+
+void sched_tick() {
+
+	current_tick++;
+
+	int8_t* slot = &wheel[current_tick & (SCHED_WHEEL_SIZE - 1)];
+	int8_t due = -1;		//Tasks due this tick, in registration order
+	int8_t* due_last = &due;
+
+	//Unlink due tasks, the rest are one or more wheel turns away
+	while(*slot != -1) {
+		int8_t id = *slot;
+
+		if(tasks[id].deadline == current_tick) {
+			*slot = tasks[id].next;
+			tasks[id].next = -1;
+			*due_last = id;
+			due_last = &tasks[id].next;
+		} else slot = &tasks[id].next;
+	}
+
+	while(due != -1) {
+		int8_t id = due;
+		due = tasks[id].next;
+
+		tasks[id].callback(tasks[id].arg);
+
+		//Rates that don't divide SCHED_HZ alternate between periods so the average stays exact
+		tasks[id].calls++;
+		tasks[id].deadline = tasks[id].start + (uint32_t) (((uint64_t) tasks[id].calls + 1) * SCHED_HZ / tasks[id].rate);
+
+		sched_insert(id);
+	}
+}
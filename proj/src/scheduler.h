@@ -0,0 +1,53 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+//-----------------------------------------------------
+//Scheduler Types
+//-----------------------------------------------------
+
+//Periodic callback, arg is the value given to sched_register()
+typedef void (*sched_callback_t)(uint32_t arg);
+
+typedef struct {
+	sched_callback_t callback;
+	uint32_t arg;
+	uint16_t rate;		//Calls per second
+	uint32_t calls;		//Calls made since registration, deadlines are computed from it so they don't drift
+	uint32_t start;		//Tick the task was registered on
+	uint32_t deadline;	//Tick of the next call
+	int8_t next;		//Next task on the same wheel slot, -1 if last
+} sched_task_t;
+
+//-----------------------------------------------------
+//Scheduler Constants
+//-----------------------------------------------------
+
+#define SCHED_HZ			1000	//Timer 0 frequency while the scheduler is running
+#define SCHED_MAX_TASKS		8		//Maximum number of registered callbacks
+#define SCHED_WHEEL_SIZE	64		//Timer wheel slots, must be a power of 2
+#define SCHED_DEFAULT_HZ	60		//Timer 0 frequency MINIX expects
+
+//-----------------------------------------------------
+//Scheduler Function definitions
+//-----------------------------------------------------
+
+//Clears every task and reprograms Timer 0 to SCHED_HZ
+//Anything relying on MINIX clock ticks (tickdelay) runs SCHED_HZ / SCHED_DEFAULT_HZ times faster until sched_exit()
+//@return 0 upon success, -1 otherwise
+int8_t sched_init();
+
+//Restores Timer 0 to SCHED_DEFAULT_HZ
+//@return 0 upon success, -1 otherwise
+int8_t sched_exit();
+
+//Registers a periodic callback, first call happens one period after registration
+//@param callback - function to call
+//@param rate - calls per second, from 1 to SCHED_HZ
+//@param arg - value passed to the callback
+//@return task id upon success, -1 otherwise
+int8_t sched_register(sched_callback_t callback, uint16_t rate, uint32_t arg);
+
+//Advances the scheduler by one Timer 0 tick and calls every task that is due, in registration order
+void sched_tick();
+
+#endif //SCHEDULER_H
@@ -7,6 +7,7 @@
 #include "i8042.h"
 #include "helper.h"
 #include "LoLCOM.h"
+#include "mem.h"
 
 static int hook_id; //Timer 0 hook id
 static uint32_t counter = 0; //Interrupt handler counter, global to avoid changing a function that already came defined - void timer_int_handler()
@@ -165,8 +166,8 @@ int8_t speaker_PWM(uint32_t freq, char* path) {
 	rewind(fp);
 
 	//Allocate the necessary bytes for the PCM data
-	buffer = malloc((size) * sizeof(*buffer));
-	pcm = malloc((size) * sizeof(*pcm)); //Duplicate buffer that'll hold the scaled values
+	buffer = mem_alloc(MEM_AUDIO, (size) * sizeof(*buffer));
+	pcm = mem_alloc(MEM_AUDIO, (size) * sizeof(*pcm)); //Duplicate buffer that'll hold the scaled values
 
 	//Read whole file to buffer
 	fread(buffer, size, 1, fp);
@@ -177,7 +178,7 @@ int8_t speaker_PWM(uint32_t freq, char* path) {
 		pcm[i] = LUT[sample];
 	}
 
-	free(buffer);
+	mem_free(buffer);
 
 	sys_outb(TIMER_CTRL, 0x90); //mode 0 LSB only, binary
 
@@ -268,7 +269,7 @@ int8_t speaker_PWM(uint32_t freq, char* path) {
 		}
 	}
 
-	free(pcm);
+	mem_free(pcm);
 
 	sys_inb(SPEAKER_CTRL, &status);
 	sys_outb(SPEAKER_CTRL, status & 0xFC);
@@ -299,6 +300,22 @@ int8_t speaker_PWM(uint32_t freq, char* path) {
 }
 
 
+//Frees the notes loaded by speaker_square(), and the file and line buffer if it's still reading them
+static void speaker_square_free(FILE* musicfile, char* line) {
+
+	mem_free(notes);
+	mem_free(duration);
+	notes = NULL;
+	duration = NULL;
+
+	mem_free(line);
+
+	if(musicfile != NULL) {
+		fclose(musicfile);
+	}
+}
+
+
 int8_t speaker_square(char* music_path) {
 
 	char filename[128];
@@ -327,8 +344,15 @@ int8_t speaker_square(char* music_path) {
 
 		if(flags == NOTES_S) {
 			music_size = parse_ulong(line, 10);
-			notes = malloc((music_size) * sizeof(*notes)); //TODO free
-			duration = malloc((music_size) * sizeof(*notes));
+			notes = mem_alloc(MEM_AUDIO, (music_size) * sizeof(*notes));
+			duration = mem_alloc(MEM_AUDIO, (music_size) * sizeof(*duration));
+
+			if(notes == NULL || duration == NULL) {
+				printf("music: couldn't allocate %d notes\n", music_size);
+				speaker_square_free(musicfile, line);
+				return -1;
+			}
+
 			flags = LOOP;
 		} else if(flags == DURATION) {
 
@@ -347,6 +371,7 @@ int8_t speaker_square(char* music_path) {
 				flags = NOTES_S;
 			} else {
 				printf("music: amount of notes not found on 1st line of file\n");
+				speaker_square_free(musicfile, line);
 				return -1;
 			}
 		} else if(flags == LOOP) {
@@ -567,20 +592,24 @@ int8_t speaker_square(char* music_path) {
 			} else {
 				printf("it: %d\n", it);
 				printf("music: note not recognized\n");
+				speaker_square_free(musicfile, line);
 				return -1;
 			}
 
 			flags = DURATION;
 		} else {
 			printf("music: flag not recognized\n");
+			speaker_square_free(musicfile, line);
 			return -1;
 		}
 	} while(nread != -1);
 
+	mem_free(line);
 	fclose(musicfile);
 
 	//File loaded now play
 	speaker_square_play(music_size);
+	speaker_square_free(NULL, NULL);
 
 	return 0;
 }
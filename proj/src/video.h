@@ -52,4 +52,14 @@
 //Palette Colors
 #define MAX256				0xFF 		//Last color on a 256 color palette
 
+//VGA DAC, used to program the palette in 8bpp indexed modes
+#define VGA_DAC_WRITE		0x3C8		//Palette index the next DAC data writes start at
+#define VGA_DAC_DATA		0x3C9		//R, G, B of the current index, 6 bits each, index auto increments
+#define DAC_SHIFT			2			//8-bit color component to 6-bit DAC value
+
+#define PALETTE_LEVELS		6			//Levels per component of the uniform color cube (6x6x6 = 216 colors)
+#define PALETTE_KEY			MAX256		//Palette index TRANSPARENT is stored as, never shown
+#define PALETTE_PINNED		(PALETTE_LEVELS * PALETTE_LEVELS * PALETTE_LEVELS)	//First entry after the cube, exact colors of sprites and HUD
+#define PALETTE_PINNED_N	(PALETTE_KEY - PALETTE_PINNED)						//Pinned entries, colors past them use the cube
+
 #endif //_VIDEO_H
@@ -12,6 +12,9 @@
 #include "video.h"
 #include "logic.h"
 #include "LoLCOM.h"
+#include "pixel.h"
+#include "pngload.h"
+#include "mem.h"
 
 //Variables whose scope is video_gr.c
 
@@ -30,6 +33,20 @@ static unsigned h_res;			//Horizontal screen resolution in pixels
 static unsigned v_res;			//Vertical screen resolution in pixels
 static unsigned bits_per_pixel; //Number of bits per pixel to represent color in VRAM
 
+static unsigned draw_w;			//Width in pixels of the buffer draw functions write to
+static unsigned draw_h;			//Height in pixels of the buffer draw functions write to
+static uint8_t play_scale = 1;	//Integer scale the composed play area is shown with
+static char *compose_buffer;	//Play area composed 1:1 when play_scale > 1
+
+static uint8_t palette[256][3];		//Colors of the 8bpp palette before any palette effect
+static uint8_t palette_level[256];	//Component value to color cube level, used to quantize RGB
+static uint8_t palette_pinning = FALSE;	//Colors are packed to pinned entries, see vg_palette_pin()
+static uint8_t palette_pinned = 0;		//Pinned entries in use, from PALETTE_PINNED on
+
+static uint16_t rgb565_r[256];		//Component value to its RGB565 field, OR the three to get a 16bpp pixel
+static uint16_t rgb565_g[256];
+static uint16_t rgb565_b[256];
+
 //Returns to default Minix 3 text mode (0x03: 25 x 80, 16 colors)
 int vg_exit() {
   struct reg86u reg86;
@@ -63,9 +80,40 @@ int vg_init_values(unsigned short mode) {
 	h_res = info.XResolution;
 	v_res = info.YResolution;
 	bits_per_pixel = info.BitsPerPixel;
+	draw_w = h_res;
+	draw_h = v_res;
 	video_phys = info.PhysBasePtr;
 
-	double_buffer = (char*) malloc(h_res * v_res * (bits_per_pixel / 8));
+	//Only these depths have a pixel packer, checked before any image is converted
+	switch(bits_per_pixel) {
+	case 8:
+	case 24:
+	case 32:
+		break;
+	case 16:
+		//15bpp (5:5:5) modes may report 16 bits per pixel too
+		if(info.GreenMaskSize == 6) {
+			break;
+		}
+		//Falls through
+	default:
+		printf("vga: vg_init_values: mode 0x%X uses an unsupported pixel format (%d bpp)\n", mode, bits_per_pixel);
+		return -1;
+	}
+
+	double_buffer = (char*) mem_alloc(MEM_VIDEO, h_res * v_res * (bits_per_pixel / 8));
+
+	size_t i;
+	for(i = 0; i < 256; i++) {
+		rgb565_r[i] = (i & 0xF8) << 8;
+		rgb565_g[i] = (i & 0xFC) << 3;
+		rgb565_b[i] = i >> 3;
+	}
+
+	//Images are converted to the palette before the mode is set, only writing it to the DAC waits for vg_init()
+	if(bits_per_pixel == 8) {
+		vg_palette_init();
+	}
 
 	return info.PhysBasePtr;
 }
@@ -135,74 +183,293 @@ void *vg_init(unsigned short mode) {
 	if(video_mem == MAP_FAILED)
 		panic("vga: vg_init: couldn't map video memory\n");
 
+	if(bits_per_pixel == 8 && vg_palette_reset() != 0) {
+		return NULL;
+	}
+
 	return video_mem; //Virtual address of VRAM
 }
 
 
-//Draws pixel at x, y with "color"
-//Can draw in 8bpp indexed, 16bpp, 24bpp, 32bpp as long as its linear framebuffer
-int draw_pixel(unsigned short x, unsigned short y, unsigned long color) {
+void vg_palette_init() {
 
-	if(x < h_res && y < v_res && color != TRANSPARENT) {
+	size_t i;
+	for(i = 0; i < 256; i++) {
+		palette_level[i] = (i * (PALETTE_LEVELS - 1) + MAX256 / 2) / MAX256;
+	}
 
-		char* vram_t;
+	memset(palette, 0, sizeof(palette));
+	palette_pinned = 0;
+
+	//Uniform color cube, index 0 is black so memset(BLACK) still clears to black
+	uint8_t r, g, b;
+	for(r = 0; r < PALETTE_LEVELS; r++) {
+		for(g = 0; g < PALETTE_LEVELS; g++) {
+			for(b = 0; b < PALETTE_LEVELS; b++) {
+				i = r * PALETTE_LEVELS * PALETTE_LEVELS + g * PALETTE_LEVELS + b;
+				palette[i][0] = r * MAX256 / (PALETTE_LEVELS - 1);
+				palette[i][1] = g * MAX256 / (PALETTE_LEVELS - 1);
+				palette[i][2] = b * MAX256 / (PALETTE_LEVELS - 1);
+			}
+		}
+	}
 
-		//draw_pixel writes to double buffer or page outside of view
-		if(use_double_buffer == TRUE) {
-			vram_t = double_buffer;
-		} else {
-			if(vram_page == 0) {
-				vram_t = video_mem + h_res * v_res * (bits_per_pixel / 8);
-			} else {
-				vram_t = video_mem;
+	palette[PALETTE_KEY][0] = MAX256;
+	palette[PALETTE_KEY][2] = MAX256;
+}
+
+
+int8_t vg_palette_scale(const uint16_t scale[3]) {
+
+	if(bits_per_pixel != 8) {
+		return 0;
+	}
+
+	if(sys_outb(VGA_DAC_WRITE, 0) != OK) {
+		printf("vga: vg_palette_scale: sys_outb failed\n");
+		return -1;
+	}
+
+	//The whole effect is 256 * 3 port writes, no matter how many pixels are on screen
+	//Pinned entries are written unchanged, sprites and HUD aren't affected like in RGB modes
+	size_t i, c;
+	for(i = 0; i < 256; i++) {
+		for(c = 0; c < 3; c++) {
+			uint32_t value = i < PALETTE_PINNED ? (palette[i][c] * scale[c]) >> 8 : palette[i][c];
+
+			if(value > MAX256) {
+				value = MAX256;
+			}
+
+			if(sys_outb(VGA_DAC_DATA, value >> DAC_SHIFT) != OK) {
+				printf("vga: vg_palette_scale: sys_outb failed\n");
+				return -1;
 			}
 		}
+	}
 
-		vram_t += (y * h_res + x) * (bits_per_pixel / 8);
+	return 0;
+}
 
-		switch(bits_per_pixel) {
-		//Mostly used for packed pixel modes with a palette of 256 colors
-		case 8:
-			*vram_t = color & 0x000000FF;
-			break;
-		//No RGB 5:5:5 since that's a weird one
-		//RGB 5:6:5
-		case 16:
-			*vram_t = (color & 0x0000001F) | (color & 0x000000E0);
-			*(vram_t + 1) = ((color & 0x00000700) | (color & 0x0000F800)) >> 8;
-			break;
-		//RGB 8:8:8
-		case 24:
-			*vram_t = color & 0x000000FF;
-			*(vram_t + 1) = (color & 0x0000FF00) >> 8;
-			*(vram_t + 2) = (color & 0x00FF0000) >> 16;
-			break;
-		//ARGB 8:8:8:8
-		case 32:
-			*vram_t = color & 0x000000FF;
-			*(vram_t + 1) = (color & 0x0000FF00) >> 8;
-			*(vram_t + 2) = (color & 0x00FF0000) >> 16;
-			*(vram_t + 3) = (color & 0xFF000000) >> 24;
+
+int8_t vg_palette_reset() {
+
+	const uint16_t scale[3] = {256, 256, 256};
+
+	return vg_palette_scale(scale);
+}
+
+
+uint8_t vg_indexed() {
+	return bits_per_pixel == 8;
+}
+
+
+void vg_palette_pin(uint8_t pin) {
+	palette_pinning = pin;
+}
+
+
+//Returns the color cube entry closest to color
+static uint8_t vg_palette_cube(unsigned long color) {
+
+	return palette_level[(color & 0x00FF0000) >> 16] * PALETTE_LEVELS * PALETTE_LEVELS
+			+ palette_level[(color & 0x0000FF00) >> 8] * PALETTE_LEVELS
+			+ palette_level[color & 0x000000FF];
+}
+
+
+//Returns the pinned entry holding color, writing it to a free entry the first time
+//Falls back to the color cube once every pinned entry is in use
+static uint8_t vg_palette_pinned(unsigned long color) {
+
+	uint8_t r = (color & 0x00FF0000) >> 16;
+	uint8_t g = (color & 0x0000FF00) >> 8;
+	uint8_t b = color & 0x000000FF;
+
+	uint8_t i;
+	for(i = PALETTE_PINNED; i < PALETTE_PINNED + palette_pinned; i++) {
+		if(palette[i][0] == r && palette[i][1] == g && palette[i][2] == b) {
+			return i;
 		}
+	}
+
+	if(palette_pinned == PALETTE_PINNED_N) {
+		return vg_palette_cube(color);
+	}
+
+	palette[i][0] = r;
+	palette[i][1] = g;
+	palette[i][2] = b;
+
+	if(sys_outb(VGA_DAC_WRITE, i) != OK || sys_outb(VGA_DAC_DATA, r >> DAC_SHIFT) != OK
+			|| sys_outb(VGA_DAC_DATA, g >> DAC_SHIFT) != OK || sys_outb(VGA_DAC_DATA, b >> DAC_SHIFT) != OK) {
+		printf("vga: vg_palette_pinned: sys_outb failed\n");
+		return vg_palette_cube(color);
+	}
+
+	palette_pinned++;
+
+	return i;
+}
+
+
+//Returns the full screen buffer the next frame goes to, double buffer or the page outside of view
+static char* vg_screen_buffer() {
+
+	if(use_double_buffer == TRUE) {
+		return double_buffer;
+	}
+
+	if(vram_page == 0) {
+		return video_mem + h_res * v_res * (bits_per_pixel / 8);
+	} else {
+		return video_mem;
+	}
+}
+
+
+//Returns the buffer draw functions write to, draw_w x draw_h pixels
+static char* vg_back_buffer() {
+
+	if(play_scale > 1) {
+		return compose_buffer;
+	}
+
+	return vg_screen_buffer();
+}
+
+
+//Writes "color" to dst in the framebuffer pixel format
+static void vg_pack_color(char* dst, unsigned long color) {
+
+	switch(bits_per_pixel) {
+	//Packed pixel modes with a palette of 256 colors, RGB is quantized to the color cube unless it's pinned
+	case 8:
+		if(color == TRANSPARENT) {
+			*dst = PALETTE_KEY;
+		} else if(palette_pinning) {
+			*dst = vg_palette_pinned(color);
+		} else {
+			*dst = vg_palette_cube(color);
+		}
+		break;
+	//No RGB 5:5:5 since that's a weird one
+	//RGB 5:6:5, each component is quantized through its table
+	case 16: {
+		uint16_t pixel = rgb565_r[(color & 0x00FF0000) >> 16] | rgb565_g[(color & 0x0000FF00) >> 8] | rgb565_b[color & 0x000000FF];
+		*dst = pixel & 0x00FF;
+		*(dst + 1) = pixel >> 8;
+		break;
+	}
+	//RGB 8:8:8
+	case 24:
+		*dst = color & 0x000000FF;
+		*(dst + 1) = (color & 0x0000FF00) >> 8;
+		*(dst + 2) = (color & 0x00FF0000) >> 16;
+		break;
+	//ARGB 8:8:8:8
+	case 32:
+		*dst = color & 0x000000FF;
+		*(dst + 1) = (color & 0x0000FF00) >> 8;
+		*(dst + 2) = (color & 0x00FF0000) >> 16;
+		*(dst + 3) = (color & 0xFF000000) >> 24;
+	}
+}
+
+
+//Converts a run of RGB pixels to the framebuffer format
+static void vg_convert_row(unsigned char* dst, const unsigned char* src, size_t npixels) {
+
+	switch(bits_per_pixel) {
+	case 24:
+		pixel_rgb_to_bgr24(dst, src, npixels);
+		break;
+	case 32:
+		pixel_rgb_to_xrgb8888((uint32_t*) dst, src, npixels);
+		break;
+	case 16:
+		pixel_rgb_to_rgb565((uint16_t*) dst, src, npixels);
+		break;
+	default: {
+		uint8_t bytes = bits_per_pixel / 8;
+
+		size_t i;
+		for(i = 0; i < npixels; i++) {
+			unsigned long color = ((unsigned long) src[i * COMPONENTS] << 16) | (src[i * COMPONENTS + 1] << 8) | src[i * COMPONENTS + 2];
+			vg_pack_color((char*) dst + i * bytes, color);
+		}
+		break;
+	}
+	}
+}
+
+
+//Draws pixel at x, y with "color"
+//Can draw in 8bpp indexed, 16bpp, 24bpp, 32bpp as long as its linear framebuffer
+int draw_pixel(unsigned short x, unsigned short y, unsigned long color) {
+
+	if(x < draw_w && y < draw_h && color != TRANSPARENT) {
+
+		//draw_pixel writes to double buffer or page outside of view
+		char* vram_t = vg_back_buffer();
+
+		vram_t += (y * draw_w + x) * (bits_per_pixel / 8);
+
+		vg_pack_color(vram_t, color);
 
 		return 0;
 	} else return -1;
 }
 
 
-int8_t vg_tile(point_t coords, uint16_t tilesheet_width, uint8_t tilesperline, unsigned char* tileset, uint8_t tilenumber) {
+//Clips a w x h rectangle drawn at coords against the draw target, once per draw call
+//Moves coords and the source origin (src_x, src_y) to the first visible pixel and shrinks w, h to the visible part
+//Returns FALSE if nothing is visible
+static uint8_t vg_clip(point_t* coords, int16_t* src_x, int16_t* src_y, int32_t* w, int32_t* h) {
 
-	unsigned short tilex = (tilenumber % tilesperline) * TILESIZE;
-	unsigned short tiley = (tilenumber / tilesperline) * TILESIZE;
+	if(coords->x < 0) {
+		*src_x -= coords->x;
+		*w += coords->x;
+		coords->x = 0;
+	}
 
-	int i, j;
-	for (i = 0; i < TILESIZE; i++) {
-		for (j = 0; j < TILESIZE; j++) {
-			unsigned long r = tileset[(tilex + j + (tiley + i) * tilesheet_width) * COMPONENTS];
-			unsigned long g = tileset[(tilex + j + (tiley + i) * tilesheet_width) * COMPONENTS + 1];
-			unsigned long b = tileset[(tilex + j + (tiley + i) * tilesheet_width) * COMPONENTS + 2];
-			unsigned long color = ((r << 16) & 0x00FF0000) | ((g << 8) & 0x0000FF00) | (b & 0x000000FF);
-			draw_pixel(coords.x + j, coords.y + i, color);
+	if(coords->y < 0) {
+		*src_y -= coords->y;
+		*h += coords->y;
+		coords->y = 0;
+	}
+
+	if(coords->x + *w > (int32_t) draw_w) *w = draw_w - coords->x;
+	if(coords->y + *h > (int32_t) draw_h) *h = draw_h - coords->y;
+
+	return *w > 0 && *h > 0;
+}
+
+
+//Draws the w x h rectangle at (src_x, src_y) of an RGB image, TRANSPARENT pixels are skipped
+static int8_t vg_draw_rgb(point_t coords, unsigned char* image, uint16_t image_width, int16_t src_x, int16_t src_y, int32_t w, int32_t h) {
+
+	if(!vg_clip(&coords, &src_x, &src_y, &w, &h)) {
+		return -1;
+	}
+
+	uint8_t bytes = bits_per_pixel / 8;
+	char* vram_t = vg_back_buffer() + (coords.y * draw_w + coords.x) * bytes;
+
+	//Everything left is on screen, no bounds checks per pixel
+	int32_t i, j;
+	for (i = 0; i < h; i++, vram_t += draw_w * bytes) {
+
+		unsigned char* src = image + (src_x + (src_y + i) * image_width) * COMPONENTS;
+		char* dst = vram_t;
+
+		for (j = 0; j < w; j++, src += COMPONENTS, dst += bytes) {
+			unsigned long color = ((unsigned long) src[0] << 16) | (src[1] << 8) | src[2];
+
+			if(color != TRANSPARENT) {
+				vg_pack_color(dst, color);
+			}
 		}
 	}
 
@@ -210,20 +477,56 @@ int8_t vg_tile(point_t coords, uint16_t tilesheet_width, uint8_t tilesperline, u
 }
 
 
-int8_t vg_font(point_t coords, uint16_t fontdata_width, uint8_t tilesperline, unsigned char* fontdata, uint8_t tilenumber) {
+//Copies the w x h rectangle at (src_x, src_y) of a surface to the back buffer at coords, rows are copied whole
+static int8_t vg_blit_rect(point_t coords, surface_t* surface, int16_t src_x, int16_t src_y, int32_t w, int32_t h) {
+
+	if(!vg_clip(&coords, &src_x, &src_y, &w, &h)) {
+		return -1;
+	}
+
+	uint8_t bytes = bits_per_pixel / 8;
+	char* vram_t = vg_back_buffer() + (coords.y * draw_w + coords.x) * bytes;
+	unsigned char* src = surface->pixels + (src_y * surface->width + src_x) * bytes;
+
+	int32_t i;
+	for(i = 0; i < h; i++, vram_t += draw_w * bytes, src += surface->width * bytes) {
+		memcpy(vram_t, src, w * bytes);
+	}
+
+	return 0;
+}
+
+
+int8_t vg_tile(point_t coords, surface_t* tiles, uint8_t tilesperline, uint8_t tilenumber) {
+
+	unsigned short tilex = (tilenumber % tilesperline) * TILESIZE;
+	unsigned short tiley = (tilenumber / tilesperline) * TILESIZE;
+
+	if(tilex + TILESIZE > tiles->width || tiley + TILESIZE > tiles->height) {
+		return -1;
+	}
+
+	return vg_blit_rect(coords, tiles, tilex, tiley, TILESIZE, TILESIZE);
+}
+
+
+int8_t vg_font(surface_t* dst, point_t coords, surface_t* glyphs, uint8_t tilesperline, uint8_t tilenumber) {
 
+	uint8_t bytes = bits_per_pixel / 8;
 	unsigned short tilex = (tilenumber % tilesperline) * FONT_W;
 	unsigned short tiley = (tilenumber / tilesperline) * FONT_H;
 
-	int i, j;
+	if(tiley + FONT_H > glyphs->height || coords.x < 0 || coords.y < 0
+			|| coords.x + FONT_W > dst->width || coords.y + FONT_H > dst->height) {
+		return -1;
+	}
+
+	//Glyph rows are already in framebuffer format, copy them whole
+	int i;
 	for (i = 0; i < FONT_H; i++) {
-		for (j = 0; j < FONT_W; j++) {
-			unsigned long r = fontdata[(tilex + j + (tiley + i) * fontdata_width) * COMPONENTS];
-			unsigned long g = fontdata[(tilex + j + (tiley + i) * fontdata_width) * COMPONENTS + 1];
-			unsigned long b = fontdata[(tilex + j + (tiley + i) * fontdata_width) * COMPONENTS + 2];
-			unsigned long color = ((r << 16) & 0x00FF0000) | ((g << 8) & 0x0000FF00) | (b & 0x000000FF);
-			draw_pixel(coords.x + j, coords.y + i, color);
-		}
+		memcpy(dst->pixels + ((coords.y + i) * dst->width + coords.x) * bytes,
+				glyphs->pixels + ((tiley + i) * glyphs->width + tilex) * bytes,
+				FONT_W * bytes);
 	}
 
 	return 0;
@@ -241,7 +544,7 @@ int8_t vg_draw_map(point_t coords) {
 		for (j = 0; j < MWIDTH; j++) {
 			tile_coords.x = coords.x + j * TILESIZE;
 			tile_coords.y = coords.y + i * TILESIZE;
-			vg_tile(tile_coords, currentmap.tileset_width, currentmap.tilesperline, currentmap.tileset, currentmap.map[j + i*MWIDTH]);
+			vg_tile(tile_coords, &currentmap.tileset->tiles, currentmap.tilesperline, currentmap.map[j + i*MWIDTH]);
 		}
 		currLine++;
 	}
@@ -252,51 +555,543 @@ int8_t vg_draw_map(point_t coords) {
 
 int8_t vg_png(point_t coords, uint16_t image_width, uint16_t image_height, unsigned char* image) {
 
-	int i, j;
-	for (i = 0; i < image_height; i++) {
-		for (j = 0; j < image_width; j++) {
-			unsigned long r = image[(j + i * image_width) * COMPONENTS];
-			unsigned long g = image[(j + i * image_width) * COMPONENTS + 1];
-			unsigned long b = image[(j + i * image_width) * COMPONENTS + 2];
-			unsigned long color = ((r << 16) & 0x00FF0000) | ((g << 8) & 0x0000FF00) | (b & 0x000000FF);
-			draw_pixel(coords.x + j, coords.y + i, color);
+	return vg_draw_rgb(coords, image, image_width, 0, 0, image_width, image_height);
+}
+
+
+int8_t vg_sprite_compile(sprite_t* sprite, unsigned char* sheet, uint16_t sheet_width, uint16_t sheet_height) {
+
+	uint8_t bytes = bits_per_pixel / 8;
+	uint8_t tilesperline = sheet_width / TILESIZE;
+	uint16_t ntiles = tilesperline * (sheet_height / TILESIZE);
+
+	if(ntiles == 0 || ntiles > 0xFF) {
+		printf("vga: vg_sprite_compile: invalid sprite sheet size %dx%d\n", sheet_width, sheet_height);
+		return -1;
+	}
+
+	//Worst case every other pixel is opaque, a row then has TILESIZE / 2 spans
+	size_t row_max = 1 + TILESIZE + TILESIZE * bytes;
+
+	sprite->data = (unsigned char*) mem_alloc(MEM_IMAGES, ntiles * TILESIZE * row_max);
+	sprite->tile_offset = (uint32_t*) mem_alloc(MEM_IMAGES, ntiles * sizeof(uint32_t));
+
+	if(sprite->data == NULL || sprite->tile_offset == NULL) {
+		printf("vga: vg_sprite_compile: couldn't allocate sprite\n");
+		vg_sprite_free(sprite);
+		return -1;
+	}
+
+	sprite->ntiles = ntiles;
+
+	unsigned char* dst = sprite->data;
+
+	uint16_t tile;
+	for(tile = 0; tile < ntiles; tile++) {
+
+		unsigned short tilex = (tile % tilesperline) * TILESIZE;
+		unsigned short tiley = (tile / tilesperline) * TILESIZE;
+
+		sprite->tile_offset[tile] = dst - sprite->data;
+
+		int i, j;
+		for(i = 0; i < TILESIZE; i++) {
+
+			unsigned char* src = sheet + (tilex + (tiley + i) * sheet_width) * COMPONENTS;
+			unsigned char row[TILESIZE * 4];
+			uint8_t mask[TILESIZE];
+
+			vg_convert_row(row, src, TILESIZE);
+			pixel_key_mask(mask, src, TILESIZE, TRANSPARENT);
+
+			unsigned char* nspans = dst++;
+			*nspans = 0;
+
+			for(j = 0; j < TILESIZE; ) {
+
+				//Transparent pixels before the next opaque run
+				uint8_t skip = 0;
+				while(j < TILESIZE && mask[j] != 0) {
+					skip++;
+					j++;
+				}
+
+				if(j == TILESIZE) {
+					break;
+				}
+
+				uint8_t length = 0;
+				while(j + length < TILESIZE && mask[j + length] == 0) {
+					length++;
+				}
+
+				*dst++ = skip;
+				*dst++ = length;
+				memcpy(dst, row + j * bytes, length * bytes);
+				dst += length * bytes;
+				(*nspans)++;
+				j += length;
+			}
 		}
 	}
 
+	//Give back the worst case space that wasn't used
+	unsigned char* data = (unsigned char*) mem_realloc(MEM_IMAGES, sprite->data, dst - sprite->data);
+	if(data != NULL) {
+		sprite->data = data;
+	}
+
 	return 0;
 }
 
 
+int8_t vg_sprite(point_t coords, sprite_t* sprite, uint8_t tilenumber) {
+
+	if(sprite == NULL || tilenumber >= sprite->ntiles) {
+		return -1;
+	}
+
+	uint8_t bytes = bits_per_pixel / 8;
+	char* vram_t = vg_back_buffer();
+	unsigned char* src = sprite->data + sprite->tile_offset[tilenumber];
+
+	int i;
+	for(i = 0; i < TILESIZE; i++) {
+
+		uint8_t nspans = *src++;
+		int32_t y = coords.y + i;
+		int32_t x = coords.x;
+		uint8_t visible = (y >= 0 && y < (int32_t) draw_h);
+
+		while(nspans-- > 0) {
+			x += *src++;
+			uint8_t length = *src++;
+
+			if(visible) {
+				//Spans are clipped whole, pixels inside are never tested
+				int32_t start = x < 0 ? 0 : x;
+				int32_t end = x + length > (int32_t) draw_w ? (int32_t) draw_w : x + length;
+
+				if(start < end) {
+					memcpy(vram_t + (y * draw_w + start) * bytes, src + (start - x) * bytes, (end - start) * bytes);
+				}
+			}
+
+			src += length * bytes;
+			x += length;
+		}
+	}
+
+	return 0;
+}
+
+
+void vg_sprite_free(sprite_t* sprite) {
+
+	mem_free(sprite->data);
+	mem_free(sprite->tile_offset);
+	sprite->data = NULL;
+	sprite->tile_offset = NULL;
+	sprite->ntiles = 0;
+}
+
+
+int8_t vg_blit_keyed(point_t coords, surface_t* surface) {
+
+	uint8_t bytes = bits_per_pixel / 8;
+	int16_t src_x = 0, src_y = 0;
+	int32_t w = surface->width, h = surface->height;
+	char key[4] = {0};
+
+	if(!vg_clip(&coords, &src_x, &src_y, &w, &h)) {
+		return -1;
+	}
+
+	vg_pack_color(key, TRANSPARENT);
+
+	char* vram_t = vg_back_buffer() + (coords.y * draw_w + coords.x) * bytes;
+
+	int32_t i, j;
+	for(i = 0; i < h; i++, vram_t += draw_w * bytes) {
+
+		unsigned char* src = surface->pixels + ((src_y + i) * surface->width + src_x) * bytes;
+
+		for(j = 0; j < w; j++, src += bytes) {
+			if(memcmp(src, key, bytes) != 0) {
+				memcpy(vram_t + j * bytes, src, bytes);
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+void vg_fade_rgb(unsigned char* dst, const unsigned char* src, size_t npixels, const uint16_t scale[COMPONENTS]) {
+
+	//One lookup table per channel, the image loop is then a table read per byte
+	unsigned char lut[COMPONENTS][256];
+
+	size_t i, c;
+	for(c = 0; c < COMPONENTS; c++) {
+		for(i = 0; i < 256; i++) {
+			uint32_t value = (i * scale[c]) >> 8;
+			lut[c][i] = value > 0xFF ? 0xFF : value;
+		}
+	}
+
+	for(i = 0; i < npixels; i++, src += COMPONENTS, dst += COMPONENTS) {
+
+		//Transparent pixels keep their color so they're still skipped when drawing
+		if(src[0] == 0xFF && src[1] == 0x00 && src[2] == 0xFF) {
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+			continue;
+		}
+
+		dst[0] = lut[0][src[0]];
+		dst[1] = lut[1][src[1]];
+		dst[2] = lut[2][src[2]];
+	}
+}
+
+
 int vg_clear() {
 
-	if(use_double_buffer == TRUE) {
-		memset(double_buffer, BLACK, h_res * v_res * (bits_per_pixel / 8));
-	} else {
-		char* vram_t;
+	memset(vg_back_buffer(), BLACK, draw_w * draw_h * (bits_per_pixel / 8));
 
-		if(vram_page == 0) {
-			vram_t = video_mem + h_res * v_res * (bits_per_pixel / 8);
-		} else {
-			vram_t = video_mem;
+	return 0;
+}
+
+
+int8_t vg_surface_alloc(surface_t* surface, uint16_t width, uint16_t height) {
+
+	surface->pixels = (unsigned char*) mem_alloc(MEM_IMAGES, width * height * (bits_per_pixel / 8));
+
+	if(surface->pixels == NULL) {
+		printf("vga: vg_surface_alloc: couldn't allocate %dx%d surface\n", width, height);
+		return -1;
+	}
+
+	surface->width = width;
+	surface->height = height;
+
+	return 0;
+}
+
+
+//Converts an RGB row to dst, TRANSPARENT pixels are then rewritten as key when there's a mask
+static void vg_convert_keyed_row(unsigned char* dst, const unsigned char* src, uint16_t width, uint8_t* mask, const char* key) {
+
+	uint8_t bytes = bits_per_pixel / 8;
+
+	vg_convert_row(dst, src, width);
+
+	if(mask != NULL) {
+		pixel_key_mask(mask, src, width, TRANSPARENT);
+
+		uint16_t j;
+		for(j = 0; j < width; j++) {
+			if(mask[j] != 0) {
+				memcpy(dst + j * bytes, key, bytes);
+			}
+		}
+	}
+}
+
+
+//Converts an RGB image into a surface allocated with its size, each row is scaled first unless scale is NULL
+static int8_t vg_surface_convert(surface_t* surface, const unsigned char* image, const uint16_t* scale, unsigned long key_color) {
+
+	uint16_t width = surface->width;
+	uint8_t bytes = bits_per_pixel / 8;
+	char key[4] = {0};
+
+	//Key mask and, when scaling, one scaled row, both freed together
+	size_t mask_size = key_color != TRANSPARENT ? width : 0;
+	size_t row_size = scale != NULL ? width * COMPONENTS : 0;
+	uint8_t* scratch = NULL;
+
+	if(mask_size + row_size != 0) {
+		scratch = (uint8_t*) mem_alloc(MEM_IMAGES, mask_size + row_size);
+
+		if(scratch == NULL) {
+			printf("vga: vg_surface_convert: couldn't allocate row buffers\n");
+			return -1;
+		}
+	}
+
+	//Color key pixels are found with a mask and rewritten after the row is converted
+	uint8_t* mask = mask_size != 0 ? scratch + row_size : NULL;
+
+	if(mask != NULL) {
+		vg_pack_color(key, key_color);
+	}
+
+	uint16_t i;
+	for(i = 0; i < surface->height; i++) {
+		const unsigned char* src = image + i * width * COMPONENTS;
+
+		if(scale != NULL) {
+			vg_fade_rgb(scratch, src, width, scale);
+			src = scratch;
+		}
+
+		vg_convert_keyed_row(surface->pixels + i * width * bytes, src, width, mask, key);
+	}
+
+	mem_free(scratch);
+
+	return 0;
+}
+
+
+int8_t vg_surface_from_rgb(surface_t* surface, unsigned char* image, uint16_t width, uint16_t height, unsigned long key_color) {
+
+	if(vg_surface_alloc(surface, width, height) != 0) {
+		return -1;
+	}
+
+	if(vg_surface_convert(surface, image, NULL, key_color) != 0) {
+		vg_surface_free(surface);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+int8_t vg_surface_fade(surface_t* surface, const unsigned char* image, const uint16_t scale[COMPONENTS], unsigned long key_color) {
+	return vg_surface_convert(surface, image, scale, key_color);
+}
+
+
+int8_t vg_surface_from_png(surface_t* surface, const png_image_t* image, unsigned long key_color) {
+
+	uint16_t width = image->width;
+	uint16_t height = image->height;
+
+	if(vg_surface_alloc(surface, width, height) != 0) {
+		return -1;
+	}
+
+	uint8_t bytes = bits_per_pixel / 8;
+	char key[4] = {0};
+
+	//Key mask and, unless the PNG is RGB, one expanded row, both freed together
+	size_t mask_size = key_color != TRANSPARENT ? width : 0;
+	size_t scratch_size = image->comps != COMPONENTS ? width * COMPONENTS : 0;
+	uint8_t* scratch = NULL;
+
+	if(mask_size + scratch_size != 0) {
+		scratch = (uint8_t*) mem_alloc(MEM_IMAGES, mask_size + scratch_size);
+
+		if(scratch == NULL) {
+			printf("vga: vg_surface_from_png: couldn't allocate row buffers\n");
+			vg_surface_free(surface);
+			return -1;
+		}
+	}
+
+	uint8_t* mask = mask_size != 0 ? scratch + scratch_size : NULL;
+
+	if(mask != NULL) {
+		vg_pack_color(key, key_color);
+	}
+
+	uint16_t i;
+	for(i = 0; i < height; i++) {
+		const uint8_t* src = png_row(image, i, scratch);
+
+		vg_convert_keyed_row(surface->pixels + i * width * bytes, src, width, mask, key);
+	}
+
+	mem_free(scratch);
+
+	return 0;
+}
+
+
+void vg_surface_clear(surface_t* surface) {
+
+	memset(surface->pixels, BLACK, surface->width * surface->height * (bits_per_pixel / 8));
+}
+
+
+void vg_surface_free(surface_t* surface) {
+
+	mem_free(surface->pixels);
+	surface->pixels = NULL;
+	surface->width = 0;
+	surface->height = 0;
+}
+
+
+int8_t vg_blit(point_t coords, surface_t* surface, uint16_t width, uint16_t height) {
+
+	int32_t w = width, h = height;
+
+	if(w > surface->width) w = surface->width;
+	if(h > surface->height) h = surface->height;
+
+	//Clip against the screen once, rows are then copied whole
+	return vg_blit_rect(coords, surface, 0, 0, w, h);
+}
+
+
+//Scales one row by 2, one store per source pixel for every pixel size
+static void vg_scale_row_2x(char* dst, const char* src, unsigned width, uint8_t bytes) {
+
+	unsigned i;
+
+	switch(bytes) {
+	case 1:
+		for(i = 0; i < width; i++) {
+			((uint16_t*) dst)[i] = (uint8_t) src[i] * 0x0101;
+		}
+		break;
+	case 2:
+		for(i = 0; i < width; i++) {
+			uint32_t p = ((const uint16_t*) src)[i];
+			((uint32_t*) dst)[i] = p | (p << 16);
+		}
+		break;
+	case 3:
+		for(i = 0; i < width; i++, src += 3, dst += 6) {
+			dst[0] = dst[3] = src[0];
+			dst[1] = dst[4] = src[1];
+			dst[2] = dst[5] = src[2];
+		}
+		break;
+	case 4:
+		for(i = 0; i < width; i++) {
+			uint64_t p = ((const uint32_t*) src)[i];
+			((uint64_t*) dst)[i] = p | (p << 32);
+		}
+		break;
+	}
+}
+
+
+//Scales one row by 3
+static void vg_scale_row_3x(char* dst, const char* src, unsigned width, uint8_t bytes) {
+
+	unsigned i;
+
+	switch(bytes) {
+	case 1:
+		for(i = 0; i < width; i++, dst += 3) {
+			dst[0] = dst[1] = dst[2] = src[i];
+		}
+		break;
+	case 2:
+		for(i = 0; i < width; i++, dst += 6) {
+			uint16_t p = ((const uint16_t*) src)[i];
+			((uint16_t*) dst)[0] = p;
+			((uint16_t*) dst)[1] = p;
+			((uint16_t*) dst)[2] = p;
 		}
+		break;
+	case 3:
+		for(i = 0; i < width; i++, src += 3, dst += 9) {
+			dst[0] = dst[3] = dst[6] = src[0];
+			dst[1] = dst[4] = dst[7] = src[1];
+			dst[2] = dst[5] = dst[8] = src[2];
+		}
+		break;
+	case 4:
+		for(i = 0; i < width; i++, dst += 12) {
+			uint32_t p = ((const uint32_t*) src)[i];
+			((uint32_t*) dst)[0] = p;
+			((uint32_t*) dst)[1] = p;
+			((uint32_t*) dst)[2] = p;
+		}
+		break;
+	}
+}
+
+
+int8_t vg_play_scale(uint16_t width, uint16_t height, uint8_t max_scale) {
 
-		memset(vram_t, BLACK, h_res * v_res * (bits_per_pixel / 8));
+	uint8_t scale = 1;
+
+	while(scale < max_scale && width * (scale + 1) <= h_res && height * (scale + 1) <= v_res) {
+		scale++;
 	}
 
+	if(scale == 1) {
+		return 0;
+	}
+
+	compose_buffer = (char*) mem_alloc(MEM_VIDEO, width * height * (bits_per_pixel / 8));
+
+	if(compose_buffer == NULL) {
+		printf("vga: vg_play_scale: couldn't allocate compose buffer, drawing 1:1\n");
+		return -1;
+	}
+
+	//Borders around the scaled area are never drawn, clear them now on every buffer
+	memset(double_buffer, BLACK, h_res * v_res * (bits_per_pixel / 8));
+	memset(video_mem, BLACK, 2 * h_res * v_res * (bits_per_pixel / 8));
+
+	play_scale = scale;
+	draw_w = width;
+	draw_h = height;
+
 	return 0;
 }
 
 
+void vg_scale_present() {
+
+	uint8_t bytes = bits_per_pixel / 8;
+	unsigned row_size = draw_w * play_scale * bytes;
+
+	char* dst = vg_screen_buffer();
+	dst += (((v_res - draw_h * play_scale) / 2) * h_res + (h_res - draw_w * play_scale) / 2) * bytes;
+
+	const char* src = compose_buffer;
+
+	unsigned i, j;
+	for(i = 0; i < draw_h; i++, src += draw_w * bytes) {
+
+		if(play_scale == 2) {
+			vg_scale_row_2x(dst, src, draw_w, bytes);
+		} else {
+			vg_scale_row_3x(dst, src, draw_w, bytes);
+		}
+
+		//The remaining rows are copies of the scaled one
+		for(j = 1; j < play_scale; j++) {
+			memcpy(dst + j * h_res * bytes, dst, row_size);
+		}
+
+		dst += play_scale * h_res * bytes;
+	}
+}
+
+
 //Free double buffer from memory
 int vg_free() {
 
-	free(double_buffer);
+	mem_free(double_buffer);
+	mem_free(compose_buffer);
+	double_buffer = NULL;
+	compose_buffer = NULL;
+	play_scale = 1;
+	draw_w = h_res;
+	draw_h = v_res;
 	return 0;
 }
 
 
 int8_t vg_refresh() {
 
+	if(play_scale > 1) {
+		vg_scale_present();
+	}
+
 	if(use_double_buffer == FALSE)  {
 		vram_page ^= BIT(0);
 		vg_pageflip();
@@ -309,8 +1104,8 @@ int8_t vg_refresh() {
 
 
 void vg_topleft(uint16_t* topleft_x, uint16_t* topleft_y) {
-	*topleft_x = (h_res - 16*TILESIZE) / 2;
-	*topleft_y = (v_res - 15*TILESIZE) / 2;
+	*topleft_x = (draw_w - PLAY_W) / 2;
+	*topleft_y = (draw_h - PLAY_H) / 2;
 }
 
 
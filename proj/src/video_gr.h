@@ -2,6 +2,7 @@
 #define VIDEO_GR_H
 
 #include "LoLCOM.h"
+#include "pngload.h"
 
 /**
  * @brief Initializes the video module in graphics mode
@@ -19,19 +20,50 @@ void *vg_init(unsigned short mode);
 //return 0 upon success, non-zero upon failure
 int vg_exit(void);
 
+//Builds the uniform color cube palette used by 8bpp modes, called by vg_init_values()
+//Nothing is written to the DAC, vg_init() does that once the mode is set
+void vg_palette_init();
+
+//Writes the palette with every color scaled per component, in 1/256 units (256 keeps the component)
+//Does nothing unless the current mode is 8bpp indexed
+//Returns 0 upon success, -1 otherwise
+int8_t vg_palette_scale(const uint16_t scale[3]);
+
+//Writes the palette back without any effect
+int8_t vg_palette_reset();
+
+//While pin is TRUE, colors packed in 8bpp modes get palette entries of their own that palette effects leave unchanged
+//Used for sprites and HUD glyphs, so effects only change the map like the per pixel effects of RGB modes
+void vg_palette_pin(uint8_t pin);
+
+//Returns TRUE if the current mode is 8bpp indexed, palette effects replace per pixel effects then
+uint8_t vg_indexed();
+
 //Draws pixel at x, y with "color"
-//Can draw in 8bpp indexed, 16bpp, 24bpp, 32bpp as long as it is linear framebuffer
+//Can draw in 8bpp indexed, 16bpp (RGB 5:6:5), 24bpp, 32bpp as long as it is linear framebuffer
 int draw_pixel(unsigned short x, unsigned short y, unsigned long color);
 
 //Initialize static variables with the info from VBE Function 01h
+//Modes other than 8bpp indexed, 16bpp (RGB 5:6:5), 24bpp and 32bpp are rejected
+//Returns the VRAM physical address, -1 upon failure
 int vg_init_values(unsigned short mode);
 
-int8_t vg_tile(point_t coords, uint16_t tilesheet_width, uint8_t tilesperline, unsigned char* tileset, uint8_t tilenumber);
+//Copies tile "tilenumber" of a tileset converted to the framebuffer format to the back buffer at coords, opaque
+//Returns 0 upon success, -1 if nothing is visible
+int8_t vg_tile(point_t coords, surface_t* tiles, uint8_t tilesperline, uint8_t tilenumber);
 
 int8_t vg_draw_map(point_t coords);
 
 int vg_clear();
 
+//Draws the play area (width x height) 1:1 to a compose buffer that vg_refresh() scales to the screen
+//Uses the largest integer scale up to max_scale that fits the current mode, nothing changes if that's 1
+//Call after vg_init(), returns 0 upon success, -1 otherwise (drawing stays 1:1)
+int8_t vg_play_scale(uint16_t width, uint16_t height, uint8_t max_scale);
+
+//Scales the compose buffer by nearest neighbour into the center of the screen buffer, called by vg_refresh()
+void vg_scale_present();
+
 //Free double buffer from memory
 int vg_free();
 
@@ -41,10 +73,58 @@ void vg_topleft(uint16_t* topleft_x, uint16_t* topleft_y);
 
 int8_t vg_pageflip();
 
-int8_t vg_font(point_t coords, uint16_t fontdata_width, uint8_t tilesperline, unsigned char* fontdata, uint8_t tilenumber);
+//Copies glyph "tilenumber" from a glyph atlas into dst at coords, both surfaces in framebuffer format
+//Returns 0 upon success, -1 if the glyph doesn't fit
+int8_t vg_font(surface_t* dst, point_t coords, surface_t* glyphs, uint8_t tilesperline, uint8_t tilenumber);
 
 int8_t vg_png(point_t coords, uint16_t image_width, uint16_t image_height, unsigned char* image);
 
 void vg_change_buffering(uint8_t mode);
 
+//Scales every channel of an RGB image, scale is in 1/256 units per component (256 keeps the channel)
+//dst and src may be the same buffer, TRANSPARENT pixels are copied unchanged
+void vg_fade_rgb(unsigned char* dst, const unsigned char* src, size_t npixels, const uint16_t scale[COMPONENTS]);
+
+//Allocates a surface of width x height pixels in the current framebuffer format
+//Returns 0 upon success, -1 otherwise
+int8_t vg_surface_alloc(surface_t* surface, uint16_t width, uint16_t height);
+
+//Converts an RGB image to a newly allocated surface in the current framebuffer format
+//Must be called after vg_init_values(), pixels with the TRANSPARENT color are stored as key_color
+//Returns 0 upon success, -1 otherwise
+int8_t vg_surface_from_rgb(surface_t* surface, unsigned char* image, uint16_t width, uint16_t height, unsigned long key_color);
+
+//Converts an RGB image again into a surface of the same size, every channel scaled like vg_fade_rgb() does
+//Used to fade a converted tileset from its RGB source, pixels with the TRANSPARENT color are stored as key_color
+//Returns 0 upon success, -1 otherwise
+int8_t vg_surface_fade(surface_t* surface, const unsigned char* image, const uint16_t scale[COMPONENTS], unsigned long key_color);
+
+//Converts a decoded PNG to a newly allocated surface in the current framebuffer format
+//Rows go from the decoded image straight to the surface, pixels with the TRANSPARENT color are stored as key_color
+//Returns 0 upon success, -1 otherwise
+int8_t vg_surface_from_png(surface_t* surface, const png_image_t* image, unsigned long key_color);
+
+void vg_surface_clear(surface_t* surface);
+
+void vg_surface_free(surface_t* surface);
+
+//Copies the top left width x height pixels of a surface to the back buffer at coords, opaque
+//Returns 0 upon success, -1 if nothing is visible
+int8_t vg_blit(point_t coords, surface_t* surface, uint16_t width, uint16_t height);
+
+//Compiles an RGB sprite sheet of TILESIZE tiles into per row span lists in the framebuffer format
+//Each tile row is stored as: span count, then per span transparent pixels to skip, opaque pixel count and the opaque pixels
+//Returns 0 upon success, -1 otherwise
+int8_t vg_sprite_compile(sprite_t* sprite, unsigned char* sheet, uint16_t sheet_width, uint16_t sheet_height);
+
+//Draws tile "tilenumber" of a compiled sprite sheet, only the opaque spans are copied
+//Returns 0 upon success, -1 if the tile doesn't exist
+int8_t vg_sprite(point_t coords, sprite_t* sprite, uint8_t tilenumber);
+
+void vg_sprite_free(sprite_t* sprite);
+
+//Copies a whole surface to the back buffer at coords, skipping pixels stored as TRANSPARENT
+//Returns 0 upon success
+int8_t vg_blit_keyed(point_t coords, surface_t* surface);
+
 #endif //VIDEO_GR_H
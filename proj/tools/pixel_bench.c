@@ -0,0 +1,149 @@
+//Micro-benchmark for the pixel format conversion kernels in src/pixel.c
+//Runs on Linux over the game's real assets, checks every SIMD kernel against its scalar version
+//
+//Build and run from proj/tools:
+//	gcc -std=gnu99 -O3 -mssse3 -I../src pixel_bench.c ../src/pixel.c -o pixel_bench -lm
+//	./pixel_bench [resources directory, default ../resources]
+//Build without -mssse3 to see the scalar fallback
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#include "stb_image.h"
+
+#include "pixel.h"
+
+#define COMPONENTS		3			//Same as the game, stb_image decodes to RGB
+#define TRANSPARENT		0xFF00FF
+#define BENCH_REPEAT	200			//Conversions of every asset per kernel
+
+static const char* assets[] = {
+	"tilesets/Overworld32.png",
+	"tilesets/Font18x14.png",
+	"sprite_sheets/Link32.png",
+	"sprite_sheets/Sword32.png",
+	"images/Menu1.png",
+	"images/Menu2.png",
+	"images/Menu3.png",
+	"images/Triforce.png",
+	"images/GameOver.png",
+	"images/Serial.png"
+};
+
+#define NASSETS		(sizeof(assets) / sizeof(assets[0]))
+
+typedef enum {BGR24, XRGB8888, RGB565, KEYMASK} kernel_t;
+
+static const char* kernel_names[] = {"rgb->bgr24", "rgb->xrgb8888", "rgb->rgb565", "key mask"};
+static const size_t kernel_bytes[] = {3, 4, 2, 1};
+
+static unsigned char* images[NASSETS];
+static size_t npixels[NASSETS];
+
+
+static double now() {
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void run(kernel_t kernel, int simd, void* dst, const uint8_t* src, size_t n) {
+
+	switch(kernel) {
+	case BGR24:
+		simd ? pixel_rgb_to_bgr24(dst, src, n) : pixel_rgb_to_bgr24_scalar(dst, src, n);
+		break;
+	case XRGB8888:
+		simd ? pixel_rgb_to_xrgb8888(dst, src, n) : pixel_rgb_to_xrgb8888_scalar(dst, src, n);
+		break;
+	case RGB565:
+		simd ? pixel_rgb_to_rgb565(dst, src, n) : pixel_rgb_to_rgb565_scalar(dst, src, n);
+		break;
+	case KEYMASK:
+		simd ? pixel_key_mask(dst, src, n, TRANSPARENT) : pixel_key_mask_scalar(dst, src, n, TRANSPARENT);
+		break;
+	}
+}
+
+
+int main(int argc, char** argv) {
+
+	const char* resources = argc > 1 ? argv[1] : "../resources";
+	size_t total = 0, largest = 0;
+
+	size_t i;
+	for(i = 0; i < NASSETS; i++) {
+		char path[256];
+		int x, y, comp;
+
+		snprintf(path, sizeof(path), "%s/%s", resources, assets[i]);
+		images[i] = stbi_load(path, &x, &y, &comp, COMPONENTS);
+
+		if(images[i] == NULL) {
+			printf("pixel_bench: couldn't load %s\n", path);
+			return 1;
+		}
+
+		npixels[i] = (size_t) x * y;
+		total += npixels[i];
+		if(npixels[i] > largest) {
+			largest = npixels[i];
+		}
+	}
+
+	printf("pixel_bench: %zu assets, %zu pixels, kernels: %s\n", NASSETS, total, pixel_kernel_name());
+
+	unsigned char* out_scalar = malloc(largest * 4);
+	unsigned char* out_simd = malloc(largest * 4);
+
+	int failed = 0;
+	kernel_t kernel;
+	for(kernel = BGR24; kernel <= KEYMASK; kernel++) {
+
+		//Both versions must produce the same bytes on every asset
+		for(i = 0; i < NASSETS; i++) {
+			memset(out_scalar, 0xAA, largest * 4);
+			memset(out_simd, 0xAA, largest * 4);
+			run(kernel, 0, out_scalar, images[i], npixels[i]);
+			run(kernel, 1, out_simd, images[i], npixels[i]);
+
+			if(memcmp(out_scalar, out_simd, largest * 4) != 0) {
+				printf("pixel_bench: %s mismatch on %s\n", kernel_names[kernel], assets[i]);
+				failed = 1;
+			}
+		}
+
+		double elapsed[2];
+		int simd;
+		for(simd = 0; simd < 2; simd++) {
+			double start = now();
+			int r;
+			for(r = 0; r < BENCH_REPEAT; r++) {
+				for(i = 0; i < NASSETS; i++) {
+					run(kernel, simd, out_simd, images[i], npixels[i]);
+				}
+			}
+			elapsed[simd] = now() - start;
+		}
+
+		double mpix = (double) total * BENCH_REPEAT / 1e6;
+		printf("%-14s scalar %8.1f Mpix/s   %s %8.1f Mpix/s   speedup %.2fx   (%zu B/pixel out)\n",
+				kernel_names[kernel], mpix / elapsed[0], pixel_kernel_name(), mpix / elapsed[1],
+				elapsed[0] / elapsed[1], kernel_bytes[kernel]);
+	}
+
+	for(i = 0; i < NASSETS; i++) {
+		stbi_image_free(images[i]);
+	}
+	free(out_scalar);
+	free(out_simd);
+
+	return failed;
+}
@@ -0,0 +1,300 @@
+//Benchmark for the PNG loading front-end in src/pngload.c against plain stbi_load()
+//Runs on Linux over the game's tilesets and menu images, checks that both paths produce the same pixels and
+//reports the arena space each one needs while loading, the front-end saves memory rather than time
+//
+//Build and run from proj/tools:
+//	gcc -std=gnu99 -O3 -mssse3 -I../src png_bench.c ../src/pngload.c ../src/pixel.c -o png_bench -lm
+//	./png_bench [resources directory, default ../resources]
+//
+//stbi_load      stbi_load() to RGB, then the whole image converted to RGB565 (old surface path)
+//front-end      png_read() in one block, png_decode() in the PNG's layout, rows converted straight to RGB565
+//rgb only       stbi_load() against png_read() + png_decode() to RGB, what tilesets and sprite sheets use
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+static void* bench_alloc(size_t size);
+static void* bench_realloc(void* ptr, size_t size);
+static void bench_free(void* ptr);
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_MALLOC(sz)			bench_alloc(sz)
+#define STBI_REALLOC(p, newsz)	bench_realloc(p, newsz)
+#define STBI_FREE(p)			bench_free(p)
+#include "stb_image.h"
+
+#include "pixel.h"
+#include "pngload.h"
+
+#define COMPONENTS		3			//Same as the game, stb_image decodes to RGB
+#define BENCH_REPEAT	50			//Loads of every image per path
+
+static const char* assets[] = {
+	"tilesets/Overworld32.png",
+	"tilesets/Font18x14.png",
+	"images/Menu1.png",
+	"images/Menu2.png",
+	"images/Menu3.png",
+	"images/Triforce.png"
+};
+
+#define NASSETS		(sizeof(assets) / sizeof(assets[0]))
+
+#define BENCH_HEADER	16			//Bytes in front of every allocation holding its size and arena offset
+#define ARENA_ALIGN		8			//Same as src/arena.h
+
+typedef enum {STBI_SURFACE, FRONTEND_SURFACE, STBI_RGB, FRONTEND_RGB, NPATHS} path_t;
+
+static const char* path_names[] = {"stbi_load", "front-end", "rgb stbi_load", "rgb front-end"};
+
+//Fill level the game's arenas would reach, see src/arena.c: only the latest allocation
+//can grow in place or be given back, everything else stays until the arena is released
+static size_t arena_used = 0;
+static size_t arena_last = 0;
+static size_t arena_high = 0;
+
+
+static size_t arena_round(size_t size) {
+	return (size + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1);
+}
+
+
+static void arena_grow(size_t to) {
+
+	arena_used = to;
+	if(to > arena_high) {
+		arena_high = to;
+	}
+}
+
+
+static void* bench_alloc(size_t size) {
+
+	size_t* block = malloc(size + BENCH_HEADER);
+
+	if(block == NULL) {
+		return NULL;
+	}
+
+	block[0] = size;
+	block[1] = arena_used;
+	arena_last = arena_used;
+	arena_grow(arena_used + arena_round(size));
+
+	return (uint8_t*) block + BENCH_HEADER;
+}
+
+
+static void* bench_realloc(void* ptr, size_t size) {
+
+	if(ptr == NULL) {
+		return bench_alloc(size);
+	}
+
+	size_t* block = (size_t*) ((uint8_t*) ptr - BENCH_HEADER);
+
+	if(block[1] != arena_last) {
+		void* moved = bench_alloc(size);
+
+		if(moved != NULL) {
+			memcpy(moved, ptr, block[0] < size ? block[0] : size);
+			free(block);
+		}
+
+		return moved;
+	}
+
+	block = realloc(block, size + BENCH_HEADER);
+
+	if(block == NULL) {
+		return NULL;
+	}
+
+	block[0] = size;
+	arena_grow(arena_last + arena_round(size));
+
+	return (uint8_t*) block + BENCH_HEADER;
+}
+
+
+static void bench_free(void* ptr) {
+
+	if(ptr == NULL) {
+		return;
+	}
+
+	size_t* block = (size_t*) ((uint8_t*) ptr - BENCH_HEADER);
+
+	if(block[1] == arena_last) {
+		arena_used = arena_last;
+	}
+
+	free(block);
+}
+
+
+static double now() {
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+//Loads path with the given method, converted pixels go to dst
+//Returns the number of pixels written, 0 upon failure
+static size_t load(path_t method, const char* path, uint16_t* dst, uint8_t* scratch) {
+
+	int x, y, comp;
+	png_file_t file;
+	png_image_t image;
+	size_t n = 0;
+	uint16_t i;
+
+	switch(method) {
+	case STBI_SURFACE:
+	case STBI_RGB: {
+		unsigned char* rgb = stbi_load(path, &x, &y, &comp, COMPONENTS);
+
+		if(rgb == NULL) {
+			return 0;
+		}
+
+		n = (size_t) x * y;
+
+		if(method == STBI_SURFACE) {
+			pixel_rgb_to_rgb565(dst, rgb, n);
+		} else memcpy(dst, rgb, n * COMPONENTS);
+
+		stbi_image_free(rgb);
+		return n;
+	}
+	default:
+		break;
+	}
+
+	if(png_read(&file, path, bench_alloc, bench_free) != 0) {
+		return 0;
+	}
+
+	if(png_decode(&image, &file, method == FRONTEND_RGB ? COMPONENTS : 0) != 0) {
+		png_file_free(&file);
+		return 0;
+	}
+
+	png_file_free(&file);
+
+	switch(method) {
+	case FRONTEND_RGB:
+		n = (size_t) image.width * image.height;
+		memcpy(dst, image.pixels, n * COMPONENTS);
+		break;
+	default:
+		for(i = 0; i < image.height; i++) {
+			const uint8_t* row = png_row(&image, i, scratch);
+			pixel_rgb_to_rgb565(dst + (size_t) i * image.width, row, image.width);
+		}
+
+		n = (size_t) image.width * image.height;
+		break;
+	}
+
+	png_image_free(&image);
+
+	return n;
+}
+
+
+int main(int argc, char** argv) {
+
+	const char* resources = argc > 1 ? argv[1] : "../resources";
+	char paths[NASSETS][256];
+	size_t largest = 0, total = 0;
+
+	size_t i;
+	for(i = 0; i < NASSETS; i++) {
+		int x, y, comp;
+
+		snprintf(paths[i], sizeof(paths[i]), "%s/%s", resources, assets[i]);
+
+		if(stbi_info(paths[i], &x, &y, &comp) == 0) {
+			printf("png_bench: couldn't load %s\n", paths[i]);
+			return 1;
+		}
+
+		total += (size_t) x * y;
+		if((size_t) x * y > largest) {
+			largest = (size_t) x * y;
+		}
+	}
+
+	printf("png_bench: %zu images, %zu pixels, kernels: %s\n", NASSETS, total, pixel_kernel_name());
+
+	uint8_t* expected = malloc(largest * COMPONENTS);
+	uint8_t* out = malloc(largest * COMPONENTS);
+	uint8_t* scratch = malloc(largest * COMPONENTS);
+
+	//Both paths must produce the same bytes on every image
+	int failed = 0;
+	for(i = 0; i < NASSETS; i++) {
+		size_t n = load(STBI_SURFACE, paths[i], (uint16_t*) expected, scratch);
+
+		if(n == 0 || load(FRONTEND_SURFACE, paths[i], (uint16_t*) out, scratch) != n || memcmp(expected, out, n * 2) != 0) {
+			printf("png_bench: front-end mismatch on %s\n", assets[i]);
+			failed = 1;
+		}
+
+		n = load(STBI_RGB, paths[i], (uint16_t*) expected, scratch);
+
+		if(n == 0 || load(FRONTEND_RGB, paths[i], (uint16_t*) out, scratch) != n || memcmp(expected, out, n * COMPONENTS) != 0) {
+			printf("png_bench: rgb front-end mismatch on %s\n", assets[i]);
+			failed = 1;
+		}
+	}
+
+	//Highest arena fill while loading any single image, the arena is released after every load like logic_lsurface_path() does
+	size_t peak[NPATHS];
+	path_t method;
+	for(method = STBI_SURFACE; method < NPATHS; method++) {
+		peak[method] = 0;
+
+		for(i = 0; i < NASSETS; i++) {
+			arena_used = arena_last = arena_high = 0;
+			load(method, paths[i], (uint16_t*) out, scratch);
+
+			if(arena_high > peak[method]) {
+				peak[method] = arena_high;
+			}
+		}
+	}
+
+	double elapsed[NPATHS];
+	for(method = STBI_SURFACE; method < NPATHS; method++) {
+		double start = now();
+		int r;
+		for(r = 0; r < BENCH_REPEAT; r++) {
+			for(i = 0; i < NASSETS; i++) {
+				load(method, paths[i], (uint16_t*) out, scratch);
+			}
+		}
+		elapsed[method] = now() - start;
+	}
+
+	double loads = (double) NASSETS * BENCH_REPEAT;
+	for(method = STBI_SURFACE; method < NPATHS; method++) {
+		path_t baseline = method == STBI_SURFACE || method == FRONTEND_SURFACE ? STBI_SURFACE : STBI_RGB;
+
+		printf("%-15s %8zu KiB arena   %8.3f ms/load   speedup %.2fx over %s\n", path_names[method], peak[method] / 1024,
+				elapsed[method] * 1e3 / loads, elapsed[baseline] / elapsed[method], path_names[baseline]);
+	}
+
+	free(expected);
+	free(out);
+	free(scratch);
+
+	return failed;
+}